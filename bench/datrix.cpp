@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../headers/datrix/datrix.hpp"
+
+// Times the Datrix kernels against glm on the same random matrices and
+// prints the largest difference between their results. Datrix a * b is
+// glm's B * A, the arrays being column-major. The chain rows time
+// a * b * c evaluated in one pass and as two products.
+
+#define DATRIX_COUNT	4096		// matrices per pass, well inside the caches
+#define DATRIX_PASSES	200
+
+template <typename Fn>
+static double ns_per_call(Fn &&fn) {
+	std::vector<double> times;
+
+	for (int run = 0; run < 5; ++run) {
+		const auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < DATRIX_PASSES; ++pass)
+			fn();
+		times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2] / (static_cast<double>(DATRIX_PASSES) * DATRIX_COUNT);
+}
+
+static float largest_difference(const float *a, const float *b, const size_t count) {
+	float largest = 0.0f;
+
+	for (size_t i = 0; i < count; ++i)
+		largest = std::max(largest, std::fabs(a[i] - b[i]));
+	return largest;
+}
+
+static void report(const char *name, const double datrix, const double glm, const float difference) {
+	std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(2)
+		<< "Datrix " << std::setw(7) << datrix << " ns   glm " << std::setw(7) << glm << " ns   "
+		<< std::setw(5) << glm / datrix << "x   difference " << std::scientific << std::setprecision(1)
+		<< difference << std::endl;
+}
+
+int main() {
+	std::mt19937							random(42);
+	std::uniform_real_distribution<float>	value(-2.0f, 2.0f);
+	std::vector<Datrix>						a(DATRIX_COUNT), b(DATRIX_COUNT), c(DATRIX_COUNT), out(DATRIX_COUNT);
+	std::vector<glm::mat4>					ga(DATRIX_COUNT), gb(DATRIX_COUNT), gc(DATRIX_COUNT), gout(DATRIX_COUNT);
+	std::vector<glm::vec4>					v(DATRIX_COUNT), vout(DATRIX_COUNT), gvout(DATRIX_COUNT);
+
+	// Kept away from singular, so the inverses compare.
+	for (size_t i = 0; i < DATRIX_COUNT; ++i) {
+		for (int j = 0; j < 16; ++j) {
+			a[i].data[j] = value(random) + (j % 5 == 0 ? 4.0f : 0.0f);
+			b[i].data[j] = value(random);
+			c[i].data[j] = value(random);
+		}
+		ga[i] = glm::make_mat4(a[i].data);
+		gb[i] = glm::make_mat4(b[i].data);
+		gc[i] = glm::make_mat4(c[i].data);
+		v[i] = glm::vec4(value(random), value(random), value(random), 1.0f);
+	}
+
+	std::vector<float> mine(DATRIX_COUNT * 16), theirs(DATRIX_COUNT * 16);
+	auto flatten = [&]() {
+		for (size_t i = 0; i < DATRIX_COUNT; ++i) {
+			std::copy(out[i].data, out[i].data + 16, mine.begin() + static_cast<std::ptrdiff_t>(i * 16));
+			std::copy(glm::value_ptr(gout[i]), glm::value_ptr(gout[i]) + 16, theirs.begin() + static_cast<std::ptrdiff_t>(i * 16));
+		}
+		return largest_difference(mine.data(), theirs.data(), mine.size());
+	};
+
+	double datrix = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) out[i] = a[i] * b[i]; });
+	double glm = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) gout[i] = gb[i] * ga[i]; });
+	report("multiply", datrix, glm, flatten());
+
+	// Both Datrix chains round as (a * b) * c, glm's as C * (B * A) would;
+	// glm's C * B * A rounds the other way.
+	datrix = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) out[i] = a[i] * b[i] * c[i]; });
+	glm = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) gout[i] = gc[i] * gb[i] * ga[i]; });
+	report("a * b * c", datrix, glm, flatten());
+	const std::vector<Datrix> fused(out);
+	datrix = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) out[i] = Datrix(Datrix(a[i] * b[i]) * c[i]); });
+	report("(a * b) * c", datrix, glm, flatten());
+	float chains = 0.0f;
+	for (size_t i = 0; i < DATRIX_COUNT; ++i)
+		chains = std::max(chains, largest_difference(fused[i].data, out[i].data, 16));
+	std::cout << "the two chains differ by " << std::scientific << chains << std::endl;
+
+	datrix = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) out[i] = a[i].transpose(); });
+	glm = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) gout[i] = glm::transpose(ga[i]); });
+	report("transpose", datrix, glm, flatten());
+
+	datrix = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) out[i] = a[i].inverse(); });
+	glm = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) gout[i] = glm::inverse(ga[i]); });
+	report("inverse", datrix, glm, flatten());
+
+	datrix = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) vout[i] = a[i].transform(v[i]); });
+	glm = ns_per_call([&]() { for (size_t i = 0; i < DATRIX_COUNT; ++i) gvout[i] = ga[i] * v[i]; });
+	report("transform", datrix, glm, largest_difference(&vout[0].x, &gvout[0].x, DATRIX_COUNT * 4));
+	return EXIT_SUCCESS;
+}
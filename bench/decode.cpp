@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../headers/textures/decoder.hpp"
+
+// Decodes every image given, or every file in textures/, with each
+// decoder built in and prints the median time of a few runs, and how far
+// the pixels of each decoder are from those of stb_image.
+
+#define DECODE_RUNS	7
+
+static double median_ms(const std::string &path, const ImageDecoder decoder, DecodedPixels &out) {
+	std::vector<double> times;
+
+	for (int run = 0; run < DECODE_RUNS; ++run) {
+		const auto start = std::chrono::steady_clock::now();
+		if (!decode_image(path, decoder, 0, out))
+			return -1.0;
+		times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+int main(int argc, char **argv) {
+	std::vector<std::string> paths(argv + 1, argv + argc);
+
+	if (paths.empty()) {
+		for (const auto &entry : std::filesystem::directory_iterator("textures"))
+			if (entry.is_regular_file() && entry.path().extension() != ".scoptex")
+				paths.push_back(entry.path().string());
+		std::sort(paths.begin(), paths.end());
+	}
+
+	std::cout << std::fixed << std::setprecision(2);
+	for (const std::string &path : paths) {
+		DecodedPixels	reference;
+		const double	reference_ms = median_ms(path, DECODER_STB, reference);
+
+		if (reference_ms < 0.0) {
+			std::cerr << path << ": could not be decoded" << std::endl;
+			continue ;
+		}
+		const double pixels = static_cast<double>(reference.width) * reference.height;
+		std::cout << path << " (" << reference.width << "x" << reference.height << ", " << reference.channels
+			<< " channels)" << std::endl;
+		for (const ImageDecoder decoder : {DECODER_STB, DECODER_LIBJPEG}) {
+			if (!image_decoder_available(decoder))
+				continue ;
+			DecodedPixels	image;
+			const double	ms = decoder == DECODER_STB ? reference_ms : median_ms(path, decoder, image);
+			const DecodedPixels &decoded = decoder == DECODER_STB ? reference : image;
+
+			std::cout << "\t" << std::left << std::setw(10) << image_decoder_name(decoder) << std::right
+				<< std::setw(9) << ms << " ms" << std::setw(9) << pixels / ms / 1000.0 << " Mpixel/s"
+				<< std::setw(7) << reference_ms / ms << "x";
+			if (decoded.width != reference.width || decoded.height != reference.height
+				|| decoded.channels != reference.channels) {
+				std::cout << "\tdifferent size" << std::endl;
+				continue ;
+			}
+			const size_t	count = static_cast<size_t>(pixels) * static_cast<size_t>(reference.channels);
+			int				largest = 0;
+			double			total = 0.0;
+			for (size_t i = 0; i < count; ++i) {
+				const int difference = std::abs(decoded.data.get()[i] - reference.data.get()[i]);
+				largest = std::max(largest, difference);
+				total += difference;
+			}
+			std::cout << "\tdifference to stb_image: " << total / static_cast<double>(count) << " mean, "
+				<< largest << " max" << std::endl;
+		}
+	}
+	return EXIT_SUCCESS;
+}
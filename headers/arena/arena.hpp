@@ -0,0 +1,28 @@
+#ifndef ARENA_HPP
+# define ARENA_HPP
+
+# include <cstddef>
+# include <memory_resource>
+
+# ifndef ARENA_BLOCK
+#  define ARENA_BLOCK	(1 << 20)	// first block of a LoadArena, in bytes
+# endif
+
+// Upstream of every LoadArena. Blocks of 2 MiB and more are mapped straight
+// from the kernel and offered to transparent huge pages; smaller ones come
+// from operator new. Stateless, so it is safe to share between threads.
+std::pmr::memory_resource	*huge_page_resource();
+
+// Bump allocator for load-time temporaries. Deallocation is a no-op: the
+// whole arena goes away at once when it is destroyed. Not thread-safe; each
+// parsing thread gets its own.
+class LoadArena final : public std::pmr::monotonic_buffer_resource {
+	public:
+		explicit LoadArena(size_t initial = ARENA_BLOCK)
+			: std::pmr::monotonic_buffer_resource(initial, huge_page_resource()) {}
+
+		LoadArena(const LoadArena &) = delete;
+		LoadArena &operator=(const LoadArena &) = delete;
+};
+
+#endif
@@ -4,7 +4,7 @@
 # include "../scop.hpp"
 
 int				init_window();
-GLFWwindow		*create_window(const Model &model);
+GLFWwindow		*create_window(const std::string &title);
 void			frame_buffer_size(GLFWwindow *window, const int w, const int h);
 
 
@@ -0,0 +1,55 @@
+#ifndef FILES_HPP
+# define FILES_HPP
+
+# include <cstddef>
+# include <cstdint>
+# include <string>
+# include <utility>
+# include <vector>
+
+// Read-only mapping of a whole file. The OBJ loader tokenizes straight out of
+// it and cache hits hand its bytes directly to OpenGL.
+class MappedFile {
+	public:
+		MappedFile();
+		explicit MappedFile(const std::string &path);
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+		MappedFile(MappedFile &&other) noexcept;
+		MappedFile &operator=(MappedFile &&other) noexcept;
+
+		bool		isOpen() const;
+		const char	*begin() const;
+		const char	*end() const;
+		size_t		size() const;
+
+	private:
+		bool		opened = false;
+		const char	*data = nullptr;
+		size_t		length = 0;
+
+		void		release();
+};
+
+// Identity of a file on disk, compared before trusting anything derived from it.
+struct FileStamp {
+	bool		exists = false;
+	uint64_t	size = 0;
+	int64_t		mtime = 0;		// nanoseconds since the epoch
+};
+
+FileStamp	stamp_file(const std::string &path);
+
+// Non-cryptographic 64-bit content hash. hash_file() hashes fixed-size blocks
+// on the thread pool and then hashes the block digests, so its value does not
+// depend on the thread count.
+uint64_t	hash_bytes(const void *data, size_t size, uint64_t seed = 0);
+uint64_t	hash_file(const MappedFile &file);
+
+// Writes the parts to a temporary file next to `path` and renames it over
+// `path`, so concurrent readers see either the old file or the new one.
+bool		write_file_atomic(const std::string &path, const std::vector<std::pair<const void *, size_t>> &parts);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef LOADER_HPP
+# define LOADER_HPP
+
+# ifndef DEBUG
+#  define DEBUG 0
+# endif
+
+# include <atomic>
+# include <exception>
+# include <mutex>		// used by loader.cpp
+# include <string>
+# include <thread>
+# include <vector>
+
+# include "../model/model.hpp"
+
+// Builds a Model on a background thread. The triangles parsed so far are
+// appended to a growing preview VBO, so the render loop can draw something
+// long before the full mesh is ready.
+class Loader final : public LoadProgress {
+	public:
+		explicit Loader(const std::string &file_path, const LoadOptions &options = LoadOptions());
+		~Loader();
+
+		Loader(const Loader &) = delete;
+		Loader &operator=(const Loader &) = delete;
+
+		void		batch(std::vector<float> &&triangles, float progress) override;
+		bool		cancelled() const override;
+
+		bool		isDone() const;
+		float		getProgress() const;
+		glm::vec3	getCenter() const;
+		Model		take();
+
+		void		upload();
+		void		draw() const;
+		void		drawProgress(GLFWwindow *window) const;
+		void		showProgress(GLFWwindow *window);		// in the window title
+
+	private:
+		std::thread						thread;
+		std::mutex						mutex;
+		std::vector<std::vector<float>>	pending;
+		std::atomic<bool>				done{false};
+		std::atomic<bool>				stop{false};
+		std::atomic<float>				progress{0.0f};
+		std::exception_ptr				error;
+		Model							model;
+
+		GLuint							vao = 0, vbo = 0;
+		size_t							capacity = 0;	// floats
+		size_t							size = 0;		// floats
+		glm::vec3						sum{};
+		int								shown_percent = -1;		// in the title
+
+		void		reserve(size_t floats);
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef INDEXER_HPP
+# define INDEXER_HPP
+
+# include <cstddef>
+# include <cstdint>
+# include <memory_resource>
+# include <vector>
+
+// Attribute indices of one face corner, 1-based as in the file. vt and vn are
+// 0 when the corner has none. A corner without vn also carries the smoothing
+// key its normal will be generated for; corners with a vn leave it at 0.
+struct Corner {
+	int	v, vt, vn, group;
+};
+
+// Open-addressing hash map from a Corner to its slot in the deduplicated
+// vertex buffer: linear probing over a power-of-two array of flat slots, so a
+// lookup touches one or two cache lines and never allocates.
+class CornerTable {
+	public:
+		explicit CornerTable(size_t expected = 0,
+			std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+		uint32_t	findOrInsert(const Corner &corner, bool &inserted);
+		size_t		size() const;
+
+	private:
+		struct Slot {
+			Corner		key;		// key.v == 0 marks an empty slot
+			uint32_t	index;
+		};
+
+		std::pmr::vector<Slot>	slots;
+		size_t					mask = 0;
+		size_t					count = 0;
+
+		void		grow();
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MESHLET_HPP
+# define MESHLET_HPP
+
+# include <cstddef>
+# include <cstdint>
+# include <vector>
+
+# include <glm/glm.hpp>
+
+# define MESHLET_MIN_TRIANGLES	64
+# define MESHLET_MAX_TRIANGLES	128
+# define MESHLET_CONE_COS		0.8f	// cosine of the widest normal past the minimum
+
+// A run of consecutive triangles of the index buffer, with what the culling
+// pass needs to reject it. The two groups of four floats are loaded as they
+// are by the SSE path.
+struct Meshlet {
+	float		center[3], radius;		// bounding sphere
+	float		axis[3], cutoff;		// normal cone: sine of its half-angle, 1 if it cannot be culled
+	uint32_t	first, count;			// indices
+};
+
+// Groups the triangles of indices[first, first + count) into meshlets of up
+// to MESHLET_MAX_TRIANGLES and reorders them so each meshlet is a range of
+// the index buffer. A meshlet grows from the first free triangle, always
+// by the neighbour closest to its average normal; past
+// MESHLET_MIN_TRIANGLES it stops before taking one further than
+// MESHLET_CONE_COS from it, which keeps the normal cones narrow enough to
+// cull. `buffer` holds `stride` floats per vertex, starting with the
+// position.
+void	build_meshlets(std::vector<uint32_t> &indices, size_t first, size_t count,
+			const std::vector<float> &buffer, size_t stride, std::vector<Meshlet> &out);
+
+// The six planes of the view frustum of `clip` (Gribb, Hartmann 2001), as
+// (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside. With the model
+// matrix folded into `clip`, the planes are in model space.
+void	frustum_planes(const glm::mat4 &clip, glm::vec4 planes[6]);
+
+// Appends to `visible` the index of every meshlet of [first, first + count)
+// that intersects the frustum and, with `backfaces` set, is not entirely
+// facing away from `eye` (in the space of the planes).
+void	cull_meshlets(const Meshlet *meshlets, size_t first, size_t count, const glm::vec4 planes[6],
+			const glm::vec3 &eye, bool backfaces, std::vector<uint32_t> &visible);
+
+#endif
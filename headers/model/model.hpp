@@ -17,6 +17,19 @@
 # include <vector>
 # include <array>			// used by model.cpp
 # include <cmath>			// used by model.cpp
+# include <memory>
+# include <memory_resource>
+
+# include "meshlet.hpp"
+# include "quantize.hpp"
+
+# define VERTEX_FLOATS 8		// x, y, z, u, v, nx, ny, nz
+
+# define LOD_LEVELS		5		// full mesh included
+# define LOD_MIN_RATIO	0.9f	// a level keeping more of the triangles than this is dropped
+
+# define SMOOTHING_OFF		0			// `s off` / `s 0`: flat normals
+# define SMOOTHING_DEFAULT	0x7fffffff	// faces before any `s` line are smoothed together
 
 # define LIGHT_POS_X 3.0f
 # define LIGHT_POS_Y 4.0f
@@ -46,6 +59,67 @@ struct Mtl {
 	int illum;
 };
 
+// Faces in compressed sparse row form: face f owns the corners
+// [offsets[f], offsets[f + 1]) of the three index arrays. Indices are 1-based
+// as in the file; a corner without vt or vn holds 0. groups holds the
+// smoothing group of each face, materials its slot in Model::materials.
+struct FaceList {
+	std::pmr::vector<uint32_t>	offsets;
+	std::pmr::vector<int>		vertices, textures, normals;
+	std::pmr::vector<int>		groups;
+	std::pmr::vector<int>		materials;
+
+	explicit FaceList(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: offsets(1, 0, resource), vertices(resource), textures(resource), normals(resource), groups(resource),
+		materials(resource) {}
+
+	size_t	size() const { return offsets.size() - 1; }
+};
+
+// A newmtl block of a .mtl file.
+struct Material {
+	std::string	name;
+	Mtl			mtl{};
+	std::string	diffuse_map;	// map_Kd, relative to the .mtl directory if not absolute
+};
+
+// The triangles of one level of detail drawn with one material: a range of
+// the index buffer, cut into a range of meshlets.
+struct Submesh {
+	uint32_t	material;
+	uint32_t	first, count;					// indices
+	uint32_t	first_meshlet, meshlet_count;
+};
+
+// A level of detail: a range of the index buffer over the vertices of the
+// full mesh, one submesh per material in material order. error bounds, in
+// model units, how far the level strays from the full mesh.
+struct MeshLod {
+	uint32_t	first, count;					// indices
+	float		error;
+	uint32_t	first_submesh, submesh_count;
+};
+
+// How a Model is built, as chosen on the command line.
+struct LoadOptions {
+	bool	optimize = true;	// reorder triangles and vertices for the GPU caches
+	bool	quantize = false;	// upload PackedVertex instead of VERTEX_FLOATS floats
+};
+
+class MappedFile;
+
+// Receives the triangles of a model while its file is still being parsed, as
+// VERTEX_FLOATS interleaved floats per vertex, along with the fraction of the
+// file read.
+// batch() is called from the loading thread.
+class LoadProgress {
+	public:
+		virtual ~LoadProgress() = default;
+
+		virtual void	batch(std::vector<float> &&triangles, float progress) = 0;
+		virtual bool	cancelled() const = 0;
+};
+
 struct Texture {
 	int				type;
 	unsigned int	id;
@@ -56,27 +130,53 @@ struct Texture {
 class Model {
 	public:
 		Model();
-		Model(const std::string &file_path);
+		Model(const std::string &file_path, LoadProgress *progress = nullptr,
+			const LoadOptions &options = LoadOptions());
+		Model(const Model &other) = default;
+		Model(Model &&other) = default;
         ~Model();
 
+		Model					&operator=(const Model &other) = default;
+		Model					&operator=(Model &&other) = default;
+
 		std::string				getName() const;
 		bool					getSlash() const;
-		Mtl						getMtl() const;
-		std::vector<float>		getTriangles() const;
-		std::vector<glm::vec3>	getNormals() const;
-		std::vector<char *>		getExternalTextures() const;
+		Mtl						getMtl() const;				// of the first material
+		size_t					getMaterialCount() const;
+		const Material			&getMaterial(size_t material) const;
+		const void				*getVertexData() const;		// PackedVertex or VERTEX_FLOATS floats
+		size_t					getVertexCount() const;
+		size_t					getVertexSize() const;		// bytes per vertex
+		bool					isQuantized() const;
+		const uint16_t			*getVertexMaterials() const;	// material slot of each vertex
+		const void				*getIndexData() const;
+		size_t					getIndexCount() const;
+		size_t					getLodCount() const;
+		const MeshLod			&getLod(size_t level) const;	// 0 is the full mesh
+		const Submesh			&getSubmesh(size_t submesh) const;
+		const Submesh			*findSubmesh(size_t level, size_t material) const;	// nullptr if unused
+		const Meshlet			*getMeshlets() const;
+		size_t					getMeshletCount() const;
+		GLenum					getIndexType() const;		// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		size_t					getIndexSize() const;		// bytes per index
+		glm::vec3				getBoundsMin() const;
+		glm::vec3				getBoundsMax() const;
+		glm::vec3				getCenter() const;			// average vertex position
+		const std::vector<char *>	&getExternalTextures() const;
 
 		void					setSlash(bool new_slash);
 
 
 		static Model			&pushVertices(Model &self, Vertex &vertex);
-		static Model			&pushFaces(Model &self, std::vector<int> &faces);
-		static Model			&pushTexturesIndices(Model &self, std::vector<int> &indices);
+		static Model			&pushFaces(Model &self, const std::vector<int> &faces);
+		static Model			&pushTexturesIndices(Model &self, const std::vector<int> &indices);
 
 		static void				loadExtenalTextures(Model &self, char **paths);
+		static void				adoptMesh(Model &self, Model &&loaded);
 
 
-		GLuint			vao, vbo, vbo_normal;
+		GLuint			vao, vbo, ebo;
+		GLuint			mbo;				// getVertexMaterials
 		int				mode = 0;
 		glm::mat4		matrix{};
 		glm::vec3		light_source{};
@@ -116,29 +216,68 @@ class Model {
 
 	private:
 		int									c = 0;			// face counter
+		int									smoothing = SMOOTHING_DEFAULT;	// group of the next face
+		int									material_slot = 0;				// material of the next face
 		bool								slash = false;
 		std::string							file_path;
 		std::string							name;
+		LoadOptions							options;
 
 		std::vector<Vertex>					vertices;
 		std::vector<UV>						textures;
-		std::vector<std::vector<int>>		textures_indices;
 
 		std::vector<char *>					external_textures;
 		unsigned int						external_textures_index = 0;
 		std::vector<glm::vec3>				normals;
-		std::vector<std::vector<int>>		faces;
-		std::vector<std::vector<Vertex> >	trigon;
-		std::vector<float>					Triangles, Squares;
-
-		Mtl									material{};
-
-		static void		loadModel(Model &self, const std::string &file_path);
-		static void		loadMaterialDefinitions(Model &self, std::istringstream &stream, std::string &prefix, std::string file_path);
+		FaceList							faces;
+		std::vector<uint32_t>				polygon_offsets;	// polygon p is polygon_corners[offsets[p]..offsets[p + 1]]
+		std::vector<uint32_t>				polygon_corners;	// indices into vertex_buffer
+		std::vector<uint32_t>				polygon_materials;
+		std::vector<uint32_t>				Triangles;			// index list
+		std::vector<float>					vertex_buffer;		// one entry per distinct (v, vt, vn)
+		std::vector<PackedVertex>			packed_vertices;	// vertex_buffer, when quantized
+		bool								quantized = false;
+		std::vector<MeshLod>				lods;				// level 0 first, then coarser ones
+		std::vector<Submesh>				submeshes;			// of every level, in order
+		std::vector<Meshlet>				meshlets;			// of every level, in order
+		std::vector<uint16_t>				vertex_materials;
+		std::vector<uint16_t>				short_indices;		// Triangles, when every index fits
+		GLenum								index_type = GL_UNSIGNED_INT;
+
+		std::vector<Material>				materials = std::vector<Material>(1);	// slot 0: faces before any usemtl
+		std::vector<Material>				material_library;	// every newmtl read, while loading
+		std::vector<std::string>			material_files;	// every .mtl looked up, for the cache
+		glm::vec3							bounds_min{}, bounds_max{}, center{};
+
+		// Set when the mesh comes from a .scopmesh file: the pointers below
+		// reference the mapping, which copies of the Model keep alive.
+		std::shared_ptr<const MappedFile>	cache;
+		const void							*cached_vertices = nullptr;
+		size_t								cached_vertex_count = 0;
+		const void							*cached_indices = nullptr;
+		size_t								cached_index_count = 0;
+		const Meshlet						*cached_meshlets = nullptr;
+		size_t								cached_meshlet_count = 0;
+		const uint16_t						*cached_vertex_materials = nullptr;
+
+		static void		loadModel(Model &self, const std::string &file_path, LoadProgress *progress);
+		static void		loadMaterialDefinitions(Model &self, const std::string &file_path);
+		static int		materialSlot(Model &self, const std::string &name);
+		static void		resolveMaterials(Model &self);
+		static bool		loadCache(Model &self, const std::string &file_path);
+		static void		saveCache(const Model &self, const std::string &file_path);
+		static void		computeBounds(Model &self);
 		static void		normalizeCoords(Model &self);
 		static void		triangleCreator(Model &self);
-		static void		filter(Model &self);
-		static void		squaredTriangles(Model &self);
+		static void		previewTriangles(const Model &self, size_t first_face, std::vector<float> &out);
+		static void		triangulate(Model &self);
+		static void		splitMaterialSeams(Model &self);
+		static void		optimizeMesh(Model &self);
+		static void		buildLods(Model &self);
+		static void		buildMeshlets(Model &self);
+		static void		assignVertexMaterials(Model &self);
+		static void		quantizeVertices(Model &self);
+		static void		packIndices(Model &self);
 
 };
 
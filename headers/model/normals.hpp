@@ -0,0 +1,17 @@
+#ifndef NORMALS_HPP
+# define NORMALS_HPP
+
+# include <cstdint>
+# include <memory_resource>
+# include <vector>
+
+// Gives every vertex of `generated` the area-weighted average normal of the
+// polygons using it. Polygons are `corners[offsets[p]..offsets[p + 1]]`, as
+// indices into `buffer` (VERTEX_FLOATS floats per vertex). Face normals are
+// computed in parallel, then each vertex gathers the faces around it, so the
+// result does not depend on the number of threads.
+void	generate_normals(std::vector<float> &buffer, const std::vector<uint32_t> &offsets,
+			const std::vector<uint32_t> &corners, const std::pmr::vector<uint32_t> &generated,
+			std::pmr::memory_resource *arena);
+
+#endif
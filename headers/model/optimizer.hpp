@@ -0,0 +1,34 @@
+#ifndef OPTIMIZER_HPP
+# define OPTIMIZER_HPP
+
+# include <cstddef>
+# include <cstdint>
+# include <vector>
+
+# ifndef VCACHE_SIZE
+#  define VCACHE_SIZE	16		// post-transform cache entries assumed
+# endif
+
+// Average cache miss ratio (transformed vertices per triangle, 0.5 at best
+// on a regular mesh) and average transform to vertex ratio (1.0 at best) of
+// a triangle list, simulated on a FIFO cache of `cache_size` entries.
+struct CacheStats {
+	float	acmr;
+	float	atvr;
+};
+
+CacheStats	cache_stats(const std::vector<uint32_t> &indices, size_t vertex_count, size_t cache_size = VCACHE_SIZE);
+
+// Tipsify (Sander, Nehab, Barczak 2007): reorders the triangles for the
+// post-transform cache, then sorts the clusters it cut at dead ends so that
+// the ones facing away from the centre of the mesh come first, which cuts
+// overdraw from any viewpoint. `buffer` holds `stride` floats per vertex,
+// starting with the position.
+void		tipsify(std::vector<uint32_t> &indices, const std::vector<float> &buffer, size_t stride,
+				size_t cache_size = VCACHE_SIZE);
+
+// Renumbers the vertices in order of first use and moves them accordingly,
+// so vertex fetches walk the buffer forward.
+void		reorder_vertices(std::vector<uint32_t> &indices, std::vector<float> &buffer, size_t stride);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef PARSER_HPP
+# define PARSER_HPP
+
+# include <cstddef>
+# include <exception>
+# include <string>
+# include <string_view>
+# include <vector>
+
+# include "model.hpp"
+# include "../files/files.hpp"
+
+// Minimum size of a parse chunk. Files smaller than this are parsed in one
+// piece; the chunk count never depends on the number of threads.
+# ifndef OBJ_CHUNK_MIN
+#  define OBJ_CHUNK_MIN (1 << 20)
+# endif
+
+// In-place scanners. They advance the cursor they are given, never read past
+// `end` (the loader passes the end of the current line) and do not depend on
+// the global locale.
+const char	*skip_blanks(const char *p, const char *end);
+const char	*line_end(const char *p, const char *end);
+bool		scan_token(const char *&p, const char *end, const char *&token, size_t &len);
+bool		scan_int(const char *&p, const char *end, int &out);
+bool		scan_float(const char *&p, const char *end, float &out);
+
+// `o`, `mtllib` and `usemtl` lines, replayed in file order once all chunks
+// are merged. The argument points into the mapped file.
+struct ObjDirective {
+	enum Kind { NAME, MTLLIB, USEMTL }	kind;
+	std::string_view					argument;
+};
+
+// Smoothing group of the faces of a chunk that come before its first `s`
+// line; resolved from the previous chunks when the chunks are merged.
+# define SMOOTHING_INHERIT	(-1)
+
+// Same for the material: faces of a chunk hold the rank of the `usemtl` in
+// effect among those of the chunk, turned into a slot of Model::materials
+// through material_slots when the chunks are merged.
+# define MATERIAL_INHERIT	(-1)
+
+// Everything parsed out of one line-aligned slice of an OBJ file, allocated
+// from the arena of the thread parsing it.
+struct ObjChunk {
+	explicit ObjChunk(std::pmr::memory_resource *resource)
+		: vertices(resource), textures(resource), normals(resource), faces(resource), directives(resource),
+		material_slots(resource) {}
+
+	std::pmr::vector<Vertex>		vertices;
+	std::pmr::vector<UV>			textures;
+	std::pmr::vector<glm::vec3>		normals;
+	FaceList						faces;
+	std::pmr::vector<ObjDirective>	directives;
+	int								faces_count = 0;
+	int								last_slash = -1;	// slash flag of the last face, -1 if none
+	int								group = SMOOTHING_INHERIT;	// current `s` group
+	int								material = MATERIAL_INHERIT;	// rank of the current `usemtl`
+	std::pmr::vector<int>			material_slots;	// slot of each `usemtl`, filled before merging
+	std::exception_ptr				error;
+};
+
+void		split_chunks(const char *begin, const char *end, std::vector<const char *> &bounds);
+void		parse_chunk(const char *begin, const char *end, ObjChunk &chunk);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef QUANTIZE_HPP
+# define QUANTIZE_HPP
+
+# include <cstdint>
+# include <vector>
+
+# include <glm/glm.hpp>
+
+// Compact vertex: 16 bytes instead of VERTEX_FLOATS * 4 = 32.
+struct PackedVertex {
+	uint16_t	position[4];	// unsigned normalized over the mesh bounds, w unused
+	uint16_t	uv[2];			// half floats
+	uint32_t	normal;			// GL_INT_2_10_10_10_REV, w unused
+};
+
+// Largest error measured over a mesh once its vertices are unpacked again.
+struct QuantizationError {
+	float	position;		// model units, any axis
+	float	uv;
+	float	normal;			// degrees
+};
+
+uint16_t			float_to_half(float value);
+float				half_to_float(uint16_t half);
+
+// Packs `buffer` (VERTEX_FLOATS floats per vertex) into `out`. Positions
+// are stored relative to [min, max]: the shader rebuilds them as
+// min + position * (max - min).
+QuantizationError	quantize_vertices(const std::vector<float> &buffer, glm::vec3 min, glm::vec3 max,
+						std::vector<PackedVertex> &out);
+
+#endif
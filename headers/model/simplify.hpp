@@ -0,0 +1,18 @@
+#ifndef SIMPLIFY_HPP
+# define SIMPLIFY_HPP
+
+# include <cstddef>
+# include <cstdint>
+# include <vector>
+
+// Quadric error metric simplification (Garland, Heckbert 1997) of the
+// triangle list `indices` down to about `target` triangles, written to `out`.
+// Edges collapse onto one of their two vertices, so `out` indexes the same
+// `buffer` (`stride` floats per vertex, starting with the position). Vertices
+// on a border or on an attribute seam (several vertices at one position)
+// never move. Returns the largest distance, in model units, between a
+// collapsed vertex and the planes of the triangles it was merged into.
+float	simplify(const std::vector<uint32_t> &indices, const std::vector<float> &buffer, size_t stride,
+			size_t target, std::vector<uint32_t> &out);
+
+#endif
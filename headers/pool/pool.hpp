@@ -0,0 +1,42 @@
+#ifndef POOL_HPP
+# define POOL_HPP
+
+# ifndef DEBUG
+#  define DEBUG 0
+# endif
+
+# include <condition_variable>
+# include <cstddef>
+# include <deque>
+# include <functional>
+# include <mutex>
+# include <thread>
+# include <vector>
+
+// Fixed set of worker threads shared by the loaders. parallelFor() lets the
+// calling thread take part in the work, so it is safe to call from a task.
+class ThreadPool {
+	public:
+		explicit ThreadPool(unsigned int threads = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator=(const ThreadPool &) = delete;
+
+		static ThreadPool	&shared();
+
+		unsigned int		size() const;
+		void				submit(std::function<void()> task);
+		void				parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+	private:
+		std::vector<std::thread>			workers;
+		std::deque<std::function<void()>>	tasks;
+		std::mutex							mutex;
+		std::condition_variable				wakeup;
+		bool								stopping = false;
+
+		void	run();
+};
+
+#endif
@@ -8,6 +8,15 @@
 # define WINDOW_W 1200
 # define WINDOW_H 1000
 
+// Projection of rendererLoop, also used to pick the level of detail.
+# define CAMERA_FOV		45.0f	// vertical, in degrees
+# define CAMERA_NEAR	0.1f
+# define CAMERA_FAR		1500.0f
+
+# define LOD_PIXEL_ERROR	1.0f	// largest error of a level on screen, in pixels
+# define LOD_HYSTERESIS		0.5f	// share of it a coarser level has to stay under
+# define LOD_FADE_FRAMES	24		// length of the crossfade between two levels
+
 // OpenGl
 # include <GL/glew.h>
 # include <GLFW/glfw3.h>
@@ -25,14 +34,27 @@
 
 // Shaders
 # include "shaders/shaders.hpp"
+# include "shaders/materials.hpp"
 
 // Camera
 # include "camera/camera.hpp"
 
+// Textures
+# include "textures/textures.hpp"
+
+// Viewer settings chosen on the command line.
+struct ViewOptions {
+	bool	cull_backfaces = false;		// hide back faces, by meshlet then by triangle
+	bool	batch_materials = false;	// one draw per level, materials looked up per vertex
+	bool	compress_textures = true;	// BC1/BC3/BC5 mip chains, see block_format
+	size_t	texture_budget = 0;			// bytes of video memory for the textures, 0 without a limit
+};
+
 // key.cpp
-void		key(GLFWwindow *window, int &version, float &light, Model &model, Camera &camera);
+void		key(GLFWwindow *window, int &version, float &light, Model &model, Camera &camera,
+			const TextureStreamer &streamer);
 
 // math_utils.cpp
-glm::vec3	calculateCenter(const std::vector<float> &triangles);
+glm::vec3	calculateCenter(const float *vertices, size_t size);
 
 #endif
\ No newline at end of file
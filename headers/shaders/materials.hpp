@@ -0,0 +1,53 @@
+#ifndef MATERIALS_HPP
+# define MATERIALS_HPP
+
+# ifndef DEBUG
+#  define DEBUG 0
+# endif
+
+# include <vector>
+
+# include "../model/model.hpp"
+
+# include <GL/glew.h>
+# include <GL/gl.h>
+
+# define MATERIAL_BATCH_MAX		256		// length of the Materials block of fragment.gls
+# define MATERIAL_MAP_MAX_SIZE	2048	// largest side of a texture array layer
+# define MATERIAL_UBO_BINDING	0
+# define MATERIAL_MAP_UNIT		1		// texture unit of materialMaps
+
+// One material of the Materials block of fragment.gls, in std140 layout.
+struct GpuMaterial {
+	float	ka[4], kd[4], ks[4];
+	float	d, ns, illum;
+	float	map;			// layer of materialMaps, -1 without map_Kd
+};
+
+// Every material of a model at once, so a level of detail is drawn in a
+// single call: the parameters go to the Materials uniform block, indexed by
+// the material slot of each vertex, and the map_Kd images to the layers of
+// a GL_TEXTURE_2D_ARRAY, all resized to the largest of them.
+// The uniform buffer exists from construction: the block has to be backed
+// by a buffer whenever the program draws, batched or not.
+class MaterialBatch {
+	public:
+		MaterialBatch();
+		~MaterialBatch();
+
+		MaterialBatch(const MaterialBatch &) = delete;
+		MaterialBatch &operator=(const MaterialBatch &) = delete;
+
+		bool	build(const Model &model, GLuint program);	// false past MATERIAL_BATCH_MAX materials
+		void	bind() const;
+		bool	isReady() const;
+
+	private:
+		GLuint	ubo = 0;
+		GLuint	maps = 0;
+		bool	ready = false;
+
+		GLsizei	loadMaps(const Model &model, std::vector<GpuMaterial> &materials);
+};
+
+#endif
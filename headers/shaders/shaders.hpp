@@ -25,6 +25,8 @@ class Shader {
 		~Shader();
 
 		unsigned int getId() const;
+		void setMaterial(const Model &model);
+		void useMaterial(const Mtl &mtl);
 
 	class ShaderException : public std::exception {
 		protected:
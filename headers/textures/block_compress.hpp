@@ -0,0 +1,23 @@
+#ifndef BLOCK_COMPRESS_HPP
+# define BLOCK_COMPRESS_HPP
+
+# include <cstddef>
+# include <functional>
+
+# include "texture_cache.hpp"
+
+// Block format for an image of `channels` channels: BC1 for RGB, BC3 for
+// RGBA, both only with `s3tc`, and BC5 for two channels. Grey images stay
+// uncompressed.
+TextureFormat	block_format(int channels, bool s3tc);
+
+// Encodes `raw`, a TEXTURE_RAW mip chain, level by level into `out`, block
+// rows spread over the thread pool. Each 4x4 block, clamped at the edges,
+// takes the corners of its colour bounding box, inset by 1/16, as
+// endpoints and every pixel the nearest of the interpolated colours.
+// Levels are encoded smallest first, `done` called after each; the levels
+// of `out` are all set before the first call.
+void			compress_mip_chain(const TexturePixels &raw, TextureFormat format, TexturePixels &out,
+					const std::function<void(size_t level)> &done = nullptr);
+
+#endif
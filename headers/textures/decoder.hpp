@@ -0,0 +1,37 @@
+#ifndef DECODER_HPP
+# define DECODER_HPP
+
+# ifndef DEBUG
+#  define DEBUG 0
+# endif
+
+# include <cstddef>
+# include <memory>
+# include <string>
+
+// Who decodes an image file. stb_image reads every format; libjpeg, only
+// built with SCOP_LIBJPEG, reads JPEG files with the SIMD IDCT and colour
+// conversion of libjpeg-turbo and hands anything else to stb_image.
+enum ImageDecoder {
+	DECODER_STB,
+	DECODER_LIBJPEG,
+};
+
+// Freed by whichever library allocated it.
+using PixelData = std::unique_ptr<unsigned char, void (*)(void *)>;
+
+// Level 0 of an image, `channels` bytes per pixel, rows tightly packed.
+struct DecodedPixels {
+	int			width = 0, height = 0, channels = 0;
+	PixelData	data{nullptr, nullptr};
+};
+
+bool			image_decoder_available(ImageDecoder decoder);
+ImageDecoder	default_image_decoder();		// libjpeg when built in
+const char		*image_decoder_name(ImageDecoder decoder);
+
+// Decodes the file at `path` into `out`, with `channels` channels, or
+// those of the file when 0. An unavailable decoder falls back to stb_image.
+bool			decode_image(const std::string &path, ImageDecoder decoder, int channels, DecodedPixels &out);
+
+#endif
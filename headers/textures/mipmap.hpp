@@ -0,0 +1,12 @@
+#ifndef MIPMAP_HPP
+# define MIPMAP_HPP
+
+# include <cstddef>
+
+// Next level of a mip chain, sized as OpenGL expects: each pixel of `dst`,
+// max(1, width / 2) by max(1, height / 2), is the rounded average of a 2x2
+// box of `src`. A side of 1 repeats its pixel; the last row or column of an
+// odd side is left out. Pixels are `channels` bytes, rows tightly packed.
+void	downsample_box(const unsigned char *src, int width, int height, int channels, unsigned char *dst);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef TEXTURE_CACHE_HPP
+# define TEXTURE_CACHE_HPP
+
+# ifndef DEBUG
+#  define DEBUG 0
+# endif
+
+# include <cstddef>
+# include <cstdint>
+# include <memory>
+# include <string>
+# include <vector>
+
+# include "../files/files.hpp"
+
+# define TEXTURE_MAX_LEVELS	16		// mip levels kept, enough for 32768 pixels a side
+
+// How the levels of a TexturePixels are stored.
+enum TextureFormat : uint32_t {
+	TEXTURE_RAW,		// `channels` bytes per pixel
+	TEXTURE_BC1,		// 8 bytes per 4x4 block, RGB
+	TEXTURE_BC3,		// 16 bytes per 4x4 block, RGBA
+	TEXTURE_BC5,		// 16 bytes per 4x4 block, two channels
+};
+
+struct MipLevel {
+	uint64_t	offset;			// from TexturePixels::data, 16-byte aligned
+	uint32_t	width, height;
+};
+
+// An image and its mip chain, level 0 first, each tightly packed in
+// `format`. The pixels are either owned or in a mapped .scoptex file.
+struct TexturePixels {
+	TextureFormat						format = TEXTURE_RAW;
+	int									channels = 0;		// of the image
+	std::vector<MipLevel>				levels;
+	const unsigned char					*data = nullptr;
+	size_t								size = 0;
+	std::unique_ptr<unsigned char[]>	owned;			// not zeroed: every byte is written
+	std::shared_ptr<const MappedFile>	mapping;
+
+	size_t	levelSize(size_t level) const;
+};
+
+// Fills `out` from the decoded level 0 and builds every smaller level
+// down to 1x1, with downsample_box.
+void	build_mip_chain(const unsigned char *pixels, int width, int height, int channels, TexturePixels &out);
+
+size_t	texture_level_size(TextureFormat format, int channels, uint32_t width, uint32_t height);
+
+// .scoptex: the mip chain of an image, stored next to it and mapped back
+// as long as the image content is the same. The block compressed chain,
+// `compressed`, is a second file, .bc.scoptex, so a run without S3TC
+// support keeps its own.
+bool	load_texture_cache(const std::string &image_path, bool compressed, TexturePixels &out);
+void	save_texture_cache(const std::string &image_path, bool compressed, const TexturePixels &pixels);
+
+#endif
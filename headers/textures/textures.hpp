@@ -0,0 +1,115 @@
+#ifndef TEXTURES_HPP
+# define TEXTURES_HPP
+
+# ifndef DEBUG
+#  define DEBUG 0
+# endif
+
+# include <atomic>
+# include <cstdint>
+# include <memory>
+# include <string>
+# include <vector>
+
+# include "texture_cache.hpp"
+
+# include <GL/glew.h>
+# include <GL/gl.h>
+
+# define TEXTURE_TAIL_SIZE	64		// largest side of the levels uploaded first
+
+// Mip chain of one image, read from its .scoptex or decoded on the thread
+// pool. Its levels become ready smallest first: `ready` is the first one
+// written, and `pixels.levels` is set before it moves.
+struct DecodedImage {
+	std::string			path;
+	size_t				index = 0;			// in the texture list
+	TexturePixels		pixels;				// no levels on failure
+	TexturePixels		mapped;				// pixels, mapped back from the .scoptex just written
+	std::atomic<size_t>	ready{TEXTURE_MAX_LEVELS};
+	std::atomic<bool>	done{false};
+};
+
+// Video memory of the textures, counted from the size of their levels.
+struct TextureStats {
+	size_t	budget = 0;			// bytes, 0 without a limit
+	size_t	resident = 0;		// bytes of the levels uploaded
+	size_t	full = 0;			// bytes with every level uploaded
+	size_t	textures = 0;		// resident
+	size_t	reduced = 0;		// resident without their top levels
+	size_t	dropped = 0;		// levels dropped so far
+	size_t	restored = 0;		// levels uploaded again so far
+};
+
+// The textures given on the command line, switched with T. Each one is
+// loaded once and stays resident, so switching back to it only changes
+// the binding. Loading reads the mip chain of the image from its .scoptex,
+// or decodes the image and writes the .scoptex, on the thread pool.
+// The requested texture loads first, then the others in the order T
+// reaches them.
+// With `compress`, chains are block compressed once and read from the
+// .bc.scoptex after that (see block_format).
+//
+// Textures stream in: the levels up to TEXTURE_TAIL_SIZE go first, so a
+// blurry texture shows a frame or two after its chain is ready, then one
+// level at a time, each moving GL_TEXTURE_BASE_LEVEL down once resident.
+// Levels are copied to a pixel unpack buffer the upload reads from, and a
+// fence tells when they are resident, so the render loop never waits on a
+// file or on the driver. One upload is in flight at a time, the shown
+// texture's first.
+//
+// With a `budget` in bytes, a texture only streams in the levels that fit,
+// and the least recently shown textures give up their top level, one at a
+// time, until the shown one has all the levels the budget allows. Giving
+// up a level uploads the texture again without it so its memory is freed;
+// the chain stays mapped from its .scoptex to stream it back when shown.
+class TextureStreamer {
+	public:
+		TextureStreamer(std::vector<std::string> paths, bool compress, size_t budget);
+		~TextureStreamer();
+
+		TextureStreamer(const TextureStreamer &) = delete;
+		TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+		void	request(size_t texture);	// the latest request wins
+		GLuint	poll();						// once per frame: the texture to bind, 0 before the first one
+
+		const TextureStats	&getStats() const;
+
+	private:
+		struct Resident {
+			std::shared_ptr<DecodedImage>	image;			// from the start of its load
+			GLuint							id = 0;			// 0 until uploaded
+			size_t							base = 0;		// first level uploaded
+			size_t							reached = SIZE_MAX;	// smallest base so far
+			uint64_t						used = 0;		// frame it was last shown
+			bool							failed = false;	// not retried
+		};
+
+		std::vector<std::string>		paths;
+		bool							compress;
+		bool							s3tc;			// BC1 and BC3 can be uploaded
+		size_t							requested = SIZE_MAX;
+		size_t							shown = SIZE_MAX;
+		std::vector<Resident>			textures;		// per path
+		TextureStats					stats;
+		uint64_t						frame = 0;
+		std::shared_ptr<DecodedImage>	decoding;
+		size_t							uploading = SIZE_MAX;
+		size_t							uploading_base = 0;
+		GLuint							next = 0;		// replacing the texture uploading, 0 when adding a level
+		GLuint							pbo = 0;
+		GLsync							fence = nullptr;
+
+		size_t	pending() const;
+		size_t	fittingBase(size_t texture, size_t room) const;
+		size_t	leastRecentlyUsed() const;
+		bool	step(size_t texture, bool evict);
+		bool	stream();
+		void	decode(size_t texture);
+		void	upload(size_t texture, size_t base);
+		void	finishUpload();
+		GLuint	bound() const;
+};
+
+#endif
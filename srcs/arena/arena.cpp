@@ -0,0 +1,43 @@
+#include <new>
+#include <sys/mman.h>
+
+#include "../../headers/arena/arena.hpp"
+
+#define HUGE_PAGE	(static_cast<size_t>(2) << 20)
+
+namespace {
+
+class HugePageResource final : public std::pmr::memory_resource {
+	private:
+		void *do_allocate(const size_t bytes, const size_t alignment) override {
+			if (bytes < HUGE_PAGE)
+				return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+
+			void *addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (addr == MAP_FAILED)
+				throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+			madvise(addr, bytes, MADV_HUGEPAGE);
+#endif
+			return addr;
+		}
+
+		void do_deallocate(void *p, const size_t bytes, const size_t alignment) override {
+			if (bytes < HUGE_PAGE)
+				std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+			else
+				munmap(p, bytes);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+			return this == &other;
+		}
+};
+
+}
+
+std::pmr::memory_resource *huge_page_resource() {
+	static HugePageResource resource;
+
+	return &resource;
+}
@@ -1,37 +1,228 @@
+#include <cstring>
+
 #include "../../headers/datrix/datrix.hpp"
 
-Datrix::Datrix() {
-	data[0] = 1.0f; data[4] = 0.0f; data[8] = 0.0f; data[12] = 0.0f;
-	data[1] = 0.0f; data[5] = 1.0f; data[9] = 0.0f; data[13] = 0.0f;
-	data[2] = 0.0f; data[6] = 0.0f; data[10] = 1.0f; data[14] = 0.0f;
-	data[3] = 0.0f; data[7] = 0.0f; data[11] = 0.0f; data[15] = 1.0f;
-}
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define DATRIX_SSE 1
+#else
+# define DATRIX_SSE 0
+#endif
 
-Datrix::Datrix(const float num) {
-	data[0] = num; data[4] = 0.0f; data[8] = 0.0f; data[12] = 0.0f;
-	data[1] = 0.0f; data[5] = num; data[9] = 0.0f; data[13] = 0.0f;
-	data[2] = 0.0f; data[6] = 0.0f; data[10] = num; data[14] = 0.0f;
-	data[3] = 0.0f; data[7] = 0.0f; data[11] = 0.0f; data[15] = num;
-}
+#if defined(__AVX__)
+# include <immintrin.h>
+# define DATRIX_AVX 1
+#else
+# define DATRIX_AVX 0
+#endif
 
-Datrix::~Datrix() {
-}
+#if defined(__ARM_NEON)
+# include <arm_neon.h>
+# define DATRIX_NEON 1
+#else
+# define DATRIX_NEON 0
+#endif
 
-Datrix Datrix::operator*(const Datrix &other) const {
-	Datrix result;
+// A row of the array as four lanes. The product and the transform are
+// written once on these, for SSE and NEON alike; a scale then an add keeps
+// the rounding of the scalar a * b + c * d + ...
+#if DATRIX_SSE
+typedef __m128 Row;
+static inline Row	row_load(const float *p) { return _mm_load_ps(p); }
+static inline void	row_store(float *p, const Row r) { _mm_store_ps(p, r); }
+static inline Row	row_add(const Row a, const Row b) { return _mm_add_ps(a, b); }
+static inline Row	row_scale(const Row a, const float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+#elif DATRIX_NEON
+typedef float32x4_t Row;
+static inline Row	row_load(const float *p) { return vld1q_f32(p); }
+static inline void	row_store(float *p, const Row r) { vst1q_f32(p, r); }
+static inline Row	row_add(const Row a, const Row b) { return vaddq_f32(a, b); }
+static inline Row	row_scale(const Row a, const float s) { return vmulq_n_f32(a, s); }
+#endif
+#define DATRIX_ROWS	(DATRIX_SSE || DATRIX_NEON)
+
+void Datrix::multiplyRows(const float in[16], const float matrix[16], float out[16]) {
+#if DATRIX_AVX
+	// Two rows per register: the in-lane shuffle hands each its own coefficient.
+	const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(matrix));
+	const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(matrix + 4));
+	const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(matrix + 8));
+	const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(matrix + 12));
+
+	for (int row = 0; row < 4; row += 2) {
+		const __m256 a = _mm256_load_ps(in + row * 4);
+		__m256 sum = _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x00), b0);
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x55), b1));
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xAA), b2));
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xFF), b3));
+		_mm256_store_ps(out + row * 4, sum);
+	}
+#elif DATRIX_ROWS
+	const Row b0 = row_load(matrix), b1 = row_load(matrix + 4);
+	const Row b2 = row_load(matrix + 8), b3 = row_load(matrix + 12);
 
 	for (int row = 0; row < 4; ++row) {
+		const float a[4] = {in[row * 4], in[row * 4 + 1], in[row * 4 + 2], in[row * 4 + 3]};
+		Row sum = row_scale(b0, a[0]);
+		sum = row_add(sum, row_scale(b1, a[1]));
+		sum = row_add(sum, row_scale(b2, a[2]));
+		sum = row_add(sum, row_scale(b3, a[3]));
+		row_store(out + row * 4, sum);
+	}
+#else
+	for (int row = 0; row < 4; ++row) {
+		const float a[4] = {in[row * 4], in[row * 4 + 1], in[row * 4 + 2], in[row * 4 + 3]};
 		for (int col = 0; col < 4; ++col) {
-			result.data[row * 4 + col] =
-				data[row * 4 + 0] * other.data[0 * 4 + col] +
-				data[row * 4 + 1] * other.data[1 * 4 + col] +
-				data[row * 4 + 2] * other.data[2 * 4 + col] +
-				data[row * 4 + 3] * other.data[3 * 4 + col];
+			out[row * 4 + col] =
+				a[0] * matrix[0 * 4 + col] +
+				a[1] * matrix[1 * 4 + col] +
+				a[2] * matrix[2 * 4 + col] +
+				a[3] * matrix[3 * 4 + col];
 		}
 	}
+#endif
+}
+
+Datrix Datrix::transpose() const {
+	Datrix result;
+
+#if DATRIX_SSE
+	__m128 r0 = _mm_load_ps(data), r1 = _mm_load_ps(data + 4);
+	__m128 r2 = _mm_load_ps(data + 8), r3 = _mm_load_ps(data + 12);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_store_ps(result.data, r0);
+	_mm_store_ps(result.data + 4, r1);
+	_mm_store_ps(result.data + 8, r2);
+	_mm_store_ps(result.data + 12, r3);
+#elif DATRIX_NEON
+	const float32x4x4_t columns = vld4q_f32(data);
+	vst1q_f32(result.data, columns.val[0]);
+	vst1q_f32(result.data + 4, columns.val[1]);
+	vst1q_f32(result.data + 8, columns.val[2]);
+	vst1q_f32(result.data + 12, columns.val[3]);
+#else
+	for (int row = 0; row < 4; ++row)
+		for (int col = 0; col < 4; ++col)
+			result.data[col * 4 + row] = data[row * 4 + col];
+#endif
 	return result;
 }
 
+#if DATRIX_SSE
+
+// 2x2 blocks in a register, row by row: a b / c d.
+# define BLOCK_SWIZZLE(v, x, y, z, w)	_mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+
+// a * b
+static inline __m128 block_mul(const __m128 a, const __m128 b) {
+	return _mm_add_ps(_mm_mul_ps(a, BLOCK_SWIZZLE(b, 0, 3, 0, 3)),
+		_mm_mul_ps(BLOCK_SWIZZLE(a, 1, 0, 3, 2), BLOCK_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adjugate(a) * b
+static inline __m128 block_adj_mul(const __m128 a, const __m128 b) {
+	return _mm_sub_ps(_mm_mul_ps(BLOCK_SWIZZLE(a, 3, 3, 0, 0), b),
+		_mm_mul_ps(BLOCK_SWIZZLE(a, 1, 1, 2, 2), BLOCK_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// a * adjugate(b)
+static inline __m128 block_mul_adj(const __m128 a, const __m128 b) {
+	return _mm_sub_ps(_mm_mul_ps(a, BLOCK_SWIZZLE(b, 3, 0, 3, 0)),
+		_mm_mul_ps(BLOCK_SWIZZLE(a, 1, 0, 3, 2), BLOCK_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+#endif
+
+// By 2x2 blocks with SSE, M = (A B / C D): every block of the inverse is
+// an adjugate product of two of them over the determinant of M. The
+// scalar code expands by the 2x2 minors of the first two and last two rows.
+Datrix Datrix::inverse() const {
+	Datrix result;
+
+#if DATRIX_SSE
+	const __m128 r0 = _mm_load_ps(data), r1 = _mm_load_ps(data + 4);
+	const __m128 r2 = _mm_load_ps(data + 8), r3 = _mm_load_ps(data + 12);
+	const __m128 a = _mm_movelh_ps(r0, r1), b = _mm_movehl_ps(r1, r0);
+	const __m128 c = _mm_movelh_ps(r2, r3), d = _mm_movehl_ps(r3, r2);
+
+	// |A| |B| |C| |D|
+	const __m128 dets = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+	const __m128 det_a = BLOCK_SWIZZLE(dets, 0, 0, 0, 0), det_b = BLOCK_SWIZZLE(dets, 1, 1, 1, 1);
+	const __m128 det_c = BLOCK_SWIZZLE(dets, 2, 2, 2, 2), det_d = BLOCK_SWIZZLE(dets, 3, 3, 3, 3);
+
+	const __m128 dc = block_adj_mul(d, c);
+	const __m128 ab = block_adj_mul(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), block_mul(b, dc));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), block_mul(c, ab));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), block_mul_adj(d, ab));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), block_mul_adj(a, dc));
+
+	// |M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+	__m128 trace = _mm_mul_ps(ab, BLOCK_SWIZZLE(dc, 0, 2, 1, 3));
+	trace = _mm_add_ps(trace, BLOCK_SWIZZLE(trace, 1, 0, 3, 2));
+	trace = _mm_add_ps(trace, BLOCK_SWIZZLE(trace, 2, 3, 0, 1));
+	const __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), trace);
+	const __m128 scale = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+
+	x = _mm_mul_ps(x, scale);
+	y = _mm_mul_ps(y, scale);
+	z = _mm_mul_ps(z, scale);
+	w = _mm_mul_ps(w, scale);
+	// The adjugate of each block folded into the stores.
+	_mm_store_ps(result.data, _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_store_ps(result.data + 4, _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_store_ps(result.data + 8, _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_store_ps(result.data + 12, _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+#else
+	const float *m = data;
+	const float s0 = m[0] * m[5] - m[4] * m[1], s1 = m[0] * m[6] - m[4] * m[2];
+	const float s2 = m[0] * m[7] - m[4] * m[3], s3 = m[1] * m[6] - m[5] * m[2];
+	const float s4 = m[1] * m[7] - m[5] * m[3], s5 = m[2] * m[7] - m[6] * m[3];
+	const float c5 = m[10] * m[15] - m[14] * m[11], c4 = m[9] * m[15] - m[13] * m[11];
+	const float c3 = m[9] * m[14] - m[13] * m[10], c2 = m[8] * m[15] - m[12] * m[11];
+	const float c1 = m[8] * m[14] - m[12] * m[10], c0 = m[8] * m[13] - m[12] * m[9];
+	const float inv = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+	float *r = result.data;
+
+	r[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inv;
+	r[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inv;
+	r[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inv;
+	r[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inv;
+	r[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inv;
+	r[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inv;
+	r[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inv;
+	r[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inv;
+	r[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inv;
+	r[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inv;
+	r[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inv;
+	r[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inv;
+	r[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inv;
+	r[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inv;
+	r[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inv;
+	r[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inv;
+#endif
+	return result;
+}
+
+glm::vec4 Datrix::transform(const glm::vec4 &v) const {
+#if DATRIX_ROWS
+	alignas(16) float out[4];
+	Row sum = row_scale(row_load(data), v.x);
+	sum = row_add(sum, row_scale(row_load(data + 4), v.y));
+	sum = row_add(sum, row_scale(row_load(data + 8), v.z));
+	sum = row_add(sum, row_scale(row_load(data + 12), v.w));
+	row_store(out, sum);
+	return glm::vec4(out[0], out[1], out[2], out[3]);
+#else
+	float out[4];
+	for (int i = 0; i < 4; ++i)
+		out[i] = data[i] * v.x + data[4 + i] * v.y + data[8 + i] * v.z + data[12 + i] * v.w;
+	return glm::vec4(out[0], out[1], out[2], out[3]);
+#endif
+}
+
 
 Datrix Datrix::translate(glm::mat4 &mat, glm::vec3 offset) {
 	Datrix result;
@@ -89,28 +280,12 @@ Datrix Datrix::lookAt(glm::vec3 eye, glm::vec3 center, glm::vec3 up) {
 	return result;
 }
 
-Datrix Datrix::perspective(const float fov, const float aspect, const float near, const float far) {
-	Datrix result;
-
-	const float f = 1.0f / std::tan(fov / 2.0f);
-
-	for (int i = 0; i < 16; ++i) result.data[i] = 0.0f;
-
-	result.data[0] = f / aspect;
-	result.data[5] = f;
-	result.data[10] = (far + near) / (near - far);
-	result.data[11] = -1.0f;
-	result.data[14] = (2.0f * far * near) / (near - far);
-
-	return result;
-}
-
 glm::mat4 Datrix::lookAtGl(glm::vec3 position, glm::vec3 front, glm::vec3 up) {
 	Datrix result = lookAt(position, front, up);
 	return result.getMatrix();
 }
 
-glm::mat4 Datrix::getMatrix() {
+glm::mat4 Datrix::getMatrix() const {
 	return glm::make_mat4(data);
 }
 
@@ -118,3 +293,48 @@ glm::mat4 Datrix::convertMatrix(const Datrix &matrix) {
 	return glm::make_mat4(matrix.data);
 }
 
+
+// Checked by the compiler: the identities of the product, the fused chains
+// against products taken two at a time, and a folded perspective. Small
+// integers keep every product exact.
+static constexpr Datrix matrix_from(const float first, const float step) {
+	Datrix result(0.0f);
+
+	for (int i = 0; i < 16; ++i)
+		result.data[i] = first + step * static_cast<float>(i);
+	return result;
+}
+
+static constexpr Datrix row_major_product(const Datrix &a, const Datrix &b) {
+	Datrix result(0.0f);
+
+	for (int row = 0; row < 4; ++row)
+		for (int col = 0; col < 4; ++col)
+			for (int k = 0; k < 4; ++k)
+				result.data[row * 4 + col] += a.data[row * 4 + k] * b.data[k * 4 + col];
+	return result;
+}
+
+static constexpr Datrix DATRIX_A = matrix_from(1.0f, 1.0f);
+static constexpr Datrix DATRIX_B = matrix_from(-3.0f, 0.5f);
+static constexpr Datrix DATRIX_C = matrix_from(2.0f, -1.0f);
+
+static_assert(Datrix() == Datrix(1.0f), "the default matrix is the identity");
+static_assert(Datrix() * DATRIX_A == DATRIX_A && DATRIX_A * Datrix() == DATRIX_A, "I * A == A * I == A");
+static_assert(Datrix(2.0f) * Datrix(3.0f) == Datrix(6.0f), "scalar matrices multiply as scalars");
+static_assert(Datrix(DATRIX_A * DATRIX_B) == row_major_product(DATRIX_A, DATRIX_B), "the product of the arrays as rows");
+static_assert(Datrix(DATRIX_A * DATRIX_B * DATRIX_C) == Datrix(Datrix(DATRIX_A * DATRIX_B) * DATRIX_C),
+	"a fused chain is the products taken two at a time");
+static_assert(Datrix(DATRIX_A * (DATRIX_B * DATRIX_C)) == Datrix((DATRIX_A * DATRIX_B) * DATRIX_C), "(A * B) * C == A * (B * C)");
+static_assert(Datrix(Datrix() * Datrix() * Datrix()) == Datrix(), "I * I * I == I");
+
+// A product cannot be kept past its expression, where its operands end.
+static_assert(!std::is_copy_constructible_v<DatrixProduct<Datrix, Datrix>>, "products are not copied");
+static_assert(!std::is_convertible_v<DatrixProduct<Datrix, Datrix> &, Datrix>, "a named product is not evaluated");
+static_assert(std::is_convertible_v<DatrixProduct<Datrix, Datrix>, Datrix>, "a temporary product is");
+
+static constexpr Datrix DATRIX_SQUARE = Datrix::perspective(Datrix::radians(90.0f), 1.0f, 1.0f, 3.0f);
+static_assert(DATRIX_SQUARE.data[0] == DATRIX_SQUARE.data[5], "an aspect of 1 scales x as y");
+static_assert(DATRIX_SQUARE.data[5] > 0.9999999f && DATRIX_SQUARE.data[5] < 1.0000001f, "tan(45 degrees) == 1");
+static_assert(DATRIX_SQUARE.data[10] == -2.0f && DATRIX_SQUARE.data[14] == -3.0f, "depth maps [near, far]");
+static_assert(DATRIX_SQUARE.data[11] == -1.0f && DATRIX_SQUARE.data[15] == 0.0f, "w is the distance");
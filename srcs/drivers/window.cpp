@@ -31,9 +31,9 @@ int	init_window() {
 }
 
 
-GLFWwindow *create_window(const Model &model) {
+GLFWwindow *create_window(const std::string &title) {
 	GLFWwindow *window =
-		glfwCreateWindow(WINDOW_W, WINDOW_H, model.getName().c_str(), NULL, NULL);
+		glfwCreateWindow(WINDOW_W, WINDOW_H, title.c_str(), NULL, NULL);
 	if (!window) {
 		std::cerr << "Failed to create GLFW window" << std::endl;
 		glfwTerminate();
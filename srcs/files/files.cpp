@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../headers/files/files.hpp"
+#include "../../headers/pool/pool.hpp"
+
+// MAPPED FILE
+
+MappedFile::MappedFile() {}
+
+MappedFile::MappedFile(const std::string &path) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	struct stat st{};
+
+	if (fd < 0)
+		return ;
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return ;
+	}
+	length = static_cast<size_t>(st.st_size);
+	if (length > 0) {
+		void *addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED) {
+			close(fd);
+			length = 0;
+			return ;
+		}
+		madvise(addr, length, MADV_SEQUENTIAL);
+		data = static_cast<const char *>(addr);
+	}
+	close(fd);
+	opened = true;
+}
+
+MappedFile::~MappedFile() {
+	release();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+	: opened(other.opened), data(other.data), length(other.length) {
+	other.opened = false;
+	other.data = nullptr;
+	other.length = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+	if (this != &other) {
+		release();
+		opened = other.opened;
+		data = other.data;
+		length = other.length;
+		other.opened = false;
+		other.data = nullptr;
+		other.length = 0;
+	}
+	return *this;
+}
+
+void MappedFile::release() {
+	if (data)
+		munmap(const_cast<char *>(data), length);
+	opened = false;
+	data = nullptr;
+	length = 0;
+}
+
+bool MappedFile::isOpen() const {
+	return opened;
+}
+
+const char *MappedFile::begin() const {
+	return data;
+}
+
+const char *MappedFile::end() const {
+	return data + length;
+}
+
+size_t MappedFile::size() const {
+	return length;
+}
+
+// STAMPS
+
+FileStamp stamp_file(const std::string &path) {
+	FileStamp	stamp;
+	struct stat	st{};
+
+	if (stat(path.c_str(), &st) < 0 || !S_ISREG(st.st_mode))
+		return stamp;
+	stamp.exists = true;
+	stamp.size = static_cast<uint64_t>(st.st_size);
+	#ifdef __APPLE__
+		stamp.mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+	#else
+		stamp.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+	#endif
+	return stamp;
+}
+
+// HASH
+
+#define HASH_BLOCK (1 << 22)
+
+static const uint64_t PRIME_1 = 0x9e3779b185ebca87ull;
+static const uint64_t PRIME_2 = 0xc2b2ae3d27d4eb4full;
+static const uint64_t PRIME_3 = 0x165667b19e3779f9ull;
+
+static inline uint64_t rotl(const uint64_t x, const int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char *p) {
+	uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t round64(uint64_t acc, const uint64_t input) {
+	acc += input * PRIME_2;
+	return rotl(acc, 31) * PRIME_1;
+}
+
+// Four independent lanes over 32-byte stripes keep the multipliers busy.
+uint64_t hash_bytes(const void *data, const size_t size, const uint64_t seed) {
+	const unsigned char	*p = static_cast<const unsigned char *>(data);
+	const unsigned char	*end = p + size;
+	uint64_t			h;
+
+	if (size >= 32) {
+		uint64_t lane[4] = {seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1};
+
+		for (; p + 32 <= end; p += 32)
+			for (int i = 0; i < 4; ++i)
+				lane[i] = round64(lane[i], read64(p + 8 * i));
+		h = rotl(lane[0], 1) + rotl(lane[1], 7) + rotl(lane[2], 12) + rotl(lane[3], 18);
+		for (int i = 0; i < 4; ++i)
+			h = (h ^ round64(0, lane[i])) * PRIME_1 + PRIME_3;
+	}
+	else
+		h = seed + PRIME_3;
+	h += static_cast<uint64_t>(size);
+	for (; p + 8 <= end; p += 8)
+		h = rotl(h ^ round64(0, read64(p)), 27) * PRIME_1 + PRIME_3;
+	for (; p < end; ++p)
+		h = rotl(h ^ (*p * PRIME_3), 11) * PRIME_1;
+	h ^= h >> 33;
+	h *= PRIME_2;
+	h ^= h >> 29;
+	h *= PRIME_3;
+	h ^= h >> 32;
+	return h;
+}
+
+uint64_t hash_file(const MappedFile &file) {
+	const size_t			blocks = (file.size() + HASH_BLOCK - 1) / HASH_BLOCK;
+	std::vector<uint64_t>	digests(blocks);
+
+	ThreadPool::shared().parallelFor(blocks, [&](size_t i) {
+		const size_t offset = i * HASH_BLOCK;
+		digests[i] = hash_bytes(file.begin() + offset, std::min<size_t>(HASH_BLOCK, file.size() - offset), i);
+	});
+	return hash_bytes(digests.data(), digests.size() * sizeof(uint64_t), file.size());
+}
+
+// ATOMIC WRITES
+
+bool write_file_atomic(const std::string &path, const std::vector<std::pair<const void *, size_t>> &parts) {
+	std::string	tmp = path + ".XXXXXX";
+	const int	fd = mkstemp(&tmp[0]);
+
+	if (fd < 0)
+		return false;
+	bool ok = fchmod(fd, 0644) == 0;
+	for (const auto &part : parts) {
+		const char	*p = static_cast<const char *>(part.first);
+		size_t		left = part.second;
+
+		while (ok && left > 0) {
+			const ssize_t n = write(fd, p, left);
+			if (n < 0) {
+				ok = false;
+				break ;
+			}
+			p += n;
+			left -= static_cast<size_t>(n);
+		}
+	}
+	ok = close(fd) == 0 && ok;
+	if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+		unlink(tmp.c_str());
+		return false;
+	}
+	return true;
+}
@@ -38,11 +38,24 @@ void	movement_handler(Camera &camera, int key_pressed) {
 }
 
 
-void	key(GLFWwindow *window, int &version, float &light, Model &model, Camera &camera) {
+// Texture memory, in MiB.
+static void	print_texture_stats(const TextureStats &stats) {
+	const double mib = 1024.0 * 1024.0;
+
+	std::cout << "Textures: " << stats.textures << " resident, " << stats.reduced << " without their top levels, "
+		<< stats.resident / mib << " MiB of " << stats.full / mib << " MiB";
+	if (stats.budget)
+		std::cout << " (budget " << stats.budget / mib << " MiB)";
+	std::cout << ", " << stats.dropped << " levels dropped, " << stats.restored << " restored" << std::endl;
+}
+
+void	key(GLFWwindow *window, int &version, float &light, Model &model, Camera &camera,
+			const TextureStreamer &streamer) {
 	static bool	t_key_locker = false;
 	static bool	shift_key_locker = false;
 	static bool	m_key_locker = false;
 	static bool l_key_locker = false;
+	static bool i_key_locker = false;
 
 
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
@@ -64,7 +77,7 @@ void	key(GLFWwindow *window, int &version, float &light, Model &model, Camera &c
 		shift_key_locker = false;
 
 	if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && !t_key_locker) {
-		const std::vector<char *> textures = model.getExternalTextures();
+		const std::vector<char *> &textures = model.getExternalTextures();
 
 		if (static_cast<int>(textures.size()) == model.tex.type + 1)
 			model.tex.type = 0;
@@ -98,6 +111,13 @@ void	key(GLFWwindow *window, int &version, float &light, Model &model, Camera &c
 	if (glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE)
 		l_key_locker = false;
 
+	if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS && !i_key_locker) {
+		print_texture_stats(streamer.getStats());
+		i_key_locker = true;
+	}
+	if (glfwGetKey(window, GLFW_KEY_I) == GLFW_RELEASE)
+		i_key_locker = false;
+
 	for (const auto& i : MOVEMENT_KEYS)
 		if (glfwGetKey(window, i) == GLFW_PRESS) {
 			movement_handler(camera, i);
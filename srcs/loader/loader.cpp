@@ -0,0 +1,160 @@
+#include <algorithm>
+
+#include "../../headers/loader/loader.hpp"
+
+#define PREVIEW_MIN_FLOATS	(1 << 16)
+#define PROGRESS_BAR_H		6
+
+Loader::Loader(const std::string &file_path, const LoadOptions &options) {
+	thread = std::thread([this, file_path, options]() {
+		try {
+			model = Model(file_path, this, options);
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+		progress = 1.0f;
+		done = true;
+	});
+}
+
+Loader::~Loader() {
+	stop = true;
+	if (thread.joinable())
+		thread.join();
+	if (vbo)
+		glDeleteBuffers(1, &vbo);
+	if (vao)
+		glDeleteVertexArrays(1, &vao);
+}
+
+// LOADING THREAD
+
+void Loader::batch(std::vector<float> &&triangles, const float new_progress) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.push_back(std::move(triangles));
+	}
+	progress = new_progress;
+}
+
+bool Loader::cancelled() const {
+	return stop;
+}
+
+// RENDER THREAD
+
+bool Loader::isDone() const {
+	return done;
+}
+
+float Loader::getProgress() const {
+	return progress;
+}
+
+glm::vec3 Loader::getCenter() const {
+	return size ? sum / static_cast<float>(size / VERTEX_FLOATS) : glm::vec3(0.0f);
+}
+
+// Waits for the loading thread and rethrows whatever stopped it.
+Model Loader::take() {
+	if (thread.joinable())
+		thread.join();
+	if (error)
+		std::rethrow_exception(error);
+	return std::move(model);
+}
+
+// Buffers only grow: the old content is copied on the GPU into a buffer at
+// least twice as large, so appending stays amortized O(1).
+void Loader::reserve(const size_t floats) {
+	if (floats <= capacity)
+		return ;
+
+	const size_t	new_capacity = std::max({floats, capacity * 2, static_cast<size_t>(PREVIEW_MIN_FLOATS)});
+	GLuint			buffer;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, new_capacity * sizeof(float), nullptr, GL_DYNAMIC_DRAW); // NOLINT(*-narrowing-conversions)
+	if (vbo) {
+		glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size * sizeof(float)); // NOLINT(*-narrowing-conversions)
+		glDeleteBuffers(1, &vbo);
+	}
+	vbo = buffer;
+	capacity = new_capacity;
+
+	if (!vao)
+		glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), static_cast<void *>(nullptr));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), reinterpret_cast<void *>(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), reinterpret_cast<void *>(5 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Loader::upload() {
+	std::vector<std::vector<float>> batches;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		batches.swap(pending);
+	}
+	for (const std::vector<float> &triangles : batches) {
+		if (triangles.empty())
+			continue ;
+		reserve(size + triangles.size());
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, size * sizeof(float), triangles.size() * sizeof(float), triangles.data()); // NOLINT(*-narrowing-conversions)
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		for (size_t i = 0; i < triangles.size(); i += VERTEX_FLOATS)
+			sum += glm::vec3(triangles[i], triangles[i + 1], triangles[i + 2]);
+		size += triangles.size();
+	}
+	if constexpr (DEBUG) {
+		if (!batches.empty())
+			std::cout << "Preview: " << size / VERTEX_FLOATS << " vertices" << std::endl;
+	}
+}
+
+void Loader::draw() const {
+	if (!vao || !size)
+		return ;
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLES, 0, size / VERTEX_FLOATS); // NOLINT(*-narrowing-conversions)
+}
+
+// A bar along the bottom edge, drawn with scissored clears so it needs no
+// shader and no geometry of its own.
+void Loader::drawProgress(GLFWwindow *window) const {
+	int		w, h;
+	GLfloat	clear_color[4];
+
+	glfwGetFramebufferSize(window, &w, &h);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(0, 0, w, PROGRESS_BAR_H);
+	glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glScissor(0, 0, static_cast<int>(static_cast<float>(w) * getProgress()), PROGRESS_BAR_H);
+	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+}
+
+// Only when the percentage changes: setting a title is a round trip to the
+// window system.
+void Loader::showProgress(GLFWwindow *window) {
+	const int percent = static_cast<int>(getProgress() * 100.0f);
+
+	if (percent == shown_percent)
+		return ;
+	glfwSetWindowTitle(window, ("Loading... " + std::to_string(percent) + "%").c_str());
+	shown_percent = percent;
+}
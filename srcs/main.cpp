@@ -1,103 +1,258 @@
 #include "../headers/scop.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 #include "camera/camera.hpp"
 #include "datrix/datrix.hpp"
+#include "loader/loader.hpp"
+#include "textures/textures.hpp"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+
+// Level of detail on screen, and the one it is replacing while they fade.
+struct LodState {
+	size_t	current = 0;
+	size_t	previous = 0;
+	int		fade = LOD_FADE_FRAMES;		// frames since the last switch
+};
+
+
+// The view frustum and the camera, in the space of the model, for the
+// meshlet culling pass.
+struct ViewCull {
+	glm::vec4	planes[6];
+	glm::vec3	eye;
+	bool		backfaces;
+};
+
+// None of its arguments change, so the compiler builds it.
+static constexpr Datrix PROJECTION = Datrix::perspective(Datrix::radians(CAMERA_FOV),
+	static_cast<float>(WINDOW_W) / static_cast<float>(WINDOW_H), CAMERA_NEAR, CAMERA_FAR);
+// 1 / tan(22.5 degrees) is sqrt(2) + 1, 2.41421342f as std::tan gives it.
+static_assert(CAMERA_FOV != 45.0f || PROJECTION.data[5] == 2.41421342f, "the y scale of a 45 degree field of view");
+
+
+// Draws the meshlets [first, first + count) that survive culling.
+// Neighbouring survivors are a single range of the index buffer and are
+// merged into one draw of the glMultiDrawElements call.
+void draw(Model &model, const size_t first, const size_t count, const ViewCull &view) {
+	static std::vector<uint32_t>		visible;
+	static std::vector<GLsizei>			counts;
+	static std::vector<const void *>	offsets;
+	const Meshlet	*meshlets = model.getMeshlets();
+	size_t			end = 0;
+
+	visible.clear();
+	counts.clear();
+	offsets.clear();
+	cull_meshlets(meshlets, first, count, view.planes, view.eye, view.backfaces, visible);
+	for (const uint32_t m : visible) {
+		if (!counts.empty() && meshlets[m].first == end)
+			counts.back() += static_cast<GLsizei>(meshlets[m].count);
+		else {
+			counts.push_back(static_cast<GLsizei>(meshlets[m].count));
+			offsets.push_back(reinterpret_cast<const void *>(meshlets[m].first * model.getIndexSize()));
+		}
+		end = meshlets[m].first + meshlets[m].count;
+	}
 
+	if (counts.empty())
+		return ;
+	glBindVertexArray(model.vao);
+	glMultiDrawElements(GL_TRIANGLES, counts.data(), model.getIndexType(), offsets.data(), // NOLINT(*-narrowing-conversions)
+						static_cast<GLsizei>(counts.size()));
+}
 
-void draw(Model &model) {
-	const std::vector<float>	triangles = model.getTriangles();
 
-	glBindVertexArray(model.vao);
-	glDrawArrays(GL_TRIANGLES, 0, triangles.size()); // NOLINT(*-narrowing-conversions)
+void draw(Model &model, const Submesh &submesh, const ViewCull &view) {
+	draw(model, submesh.first_meshlet, submesh.meshlet_count, view);
 }
 
+// Every material of `level` at once: its submeshes, and so their meshlets,
+// follow each other.
+void drawLevel(Model &model, const size_t level, const ViewCull &view) {
+	const MeshLod &lod = model.getLod(level);
 
-int createTexture(Model &model, int &stopper) {
+	if (lod.submesh_count == 0)
+		return ;
+	const Submesh &first = model.getSubmesh(lod.first_submesh);
+	const Submesh &last = model.getSubmesh(lod.first_submesh + lod.submesh_count - 1);
+	draw(model, first.first_meshlet, last.first_meshlet + last.meshlet_count - first.first_meshlet, view);
+}
 
-	if (stopper != model.tex.type) {
-		const std::vector<char *> textures = model.getExternalTextures();
-		if (textures.empty())
-			return 1;
 
-		glGenTextures(1, &model.tex.id);
-		glBindTexture(GL_TEXTURE_2D, model.tex.id);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		int width, height, chs;
-		unsigned char *data =
-			stbi_load(textures[model.tex.type], &width, &height, &chs, 0);
-		if (data) {
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE,
-						 data);
-			glGenerateMipmap(GL_TEXTURE_2D);
+// Screen pixels covered by one model unit at `distance` from the camera,
+// under PROJECTION, whose y scale is 1 / tan(fov / 2).
+float pixelsPerUnit(const float distance) {
+	const float focal = static_cast<float>(WINDOW_H) / 2.0f * PROJECTION.data[5];
+
+	return focal / std::max(distance, CAMERA_NEAR);
+}
+
+// Coarsest level whose error stays under LOD_PIXEL_ERROR. Levels coarser
+// than the current one must stay under a fraction of it, so a camera resting
+// near a threshold does not switch back and forth.
+size_t selectLod(const Model &model, const glm::vec3 &eye, const size_t current) {
+	const glm::vec3	center = (model.getBoundsMin() + model.getBoundsMax()) * 0.5f;
+	const float		radius = glm::length(model.getBoundsMax() - model.getBoundsMin()) * 0.5f;
+	const float		scale = pixelsPerUnit(glm::length(eye - center) - radius);
+	size_t			level = 0;
+
+	for (size_t i = 1; i < model.getLodCount(); ++i) {
+		const float limit = i > current ? LOD_PIXEL_ERROR * LOD_HYSTERESIS : LOD_PIXEL_ERROR;
+		if (model.getLod(i).error * scale > limit)
+			break ;
+		level = i;
+	}
+	return level;
+}
+
+// Draws the submeshes of both levels that use `material`, the previous one
+// only while it fades out.
+void drawMaterial(Model &model, const size_t material, const ViewCull &view, const LodState &lod,
+	const bool fading, const GLint fade_out) {
+	if (const Submesh *submesh = model.findSubmesh(lod.current, material))
+		draw(model, *submesh, view);
+	if (!fading)
+		return ;
+	if (const Submesh *submesh = model.findSubmesh(lod.previous, material)) {
+		glUniform1i(fade_out, 1);
+		draw(model, *submesh, view);
+		glUniform1i(fade_out, 0);
+	}
+}
+
+// Switches are crossfaded over LOD_FADE_FRAMES: both levels are drawn, and
+// fragment.gls keeps complementary dither patterns of each. The material
+// uniforms change once per material, the draws are grouped under them;
+// `batched`, the materials come from MaterialBatch and each level is one
+// draw.
+void drawLods(Shader &shader, Model &model, const ViewCull &view, LodState &lod, const bool batched) {
+	const GLint	fade = glGetUniformLocation(shader.getId(), "lodFade");
+	const GLint	fade_out = glGetUniformLocation(shader.getId(), "lodFadeOut");
+
+	if (lod.fade >= LOD_FADE_FRAMES) {
+		const size_t level = selectLod(model, view.eye, lod.current);
+		if (level != lod.current) {
+			lod.previous = lod.current;
+			lod.current = level;
+			lod.fade = 0;
 		}
-		else {
-			return 1;
+	}
+	const bool fading = lod.fade < LOD_FADE_FRAMES;
+	if (fading)
+		glUniform1f(fade, static_cast<float>(++lod.fade) / LOD_FADE_FRAMES);
+	if (batched) {
+		drawLevel(model, lod.current, view);
+		if (fading) {
+			glUniform1i(fade_out, 1);
+			drawLevel(model, lod.previous, view);
+			glUniform1i(fade_out, 0);
 		}
-		stbi_image_free(data);
-		stopper = model.tex.type;
-		return 0;
 	}
-	return 0;
+	else {
+		for (size_t material = 0; material < model.getMaterialCount(); ++material) {
+			if (model.getMaterialCount() > 1)
+				shader.useMaterial(model.getMaterial(material).mtl);
+			drawMaterial(model, material, view, lod, fading, fade_out);
+		}
+	}
+	if (fading)
+		glUniform1f(fade, 1.0f);
 }
 
 
+// On a .scopmesh hit the data pointers reference the mapped cache file,
+// which is handed to the driver without an intermediate copy.
 void createVaoVbo(Model &model) {
-	const std::vector<float>		triangles = model.getTriangles();
-	const std::vector<glm::vec3>	normals = model.getNormals();
-
 	glGenVertexArrays(1, &model.vao);
 	glGenBuffers(1, &model.vbo);
+	glGenBuffers(1, &model.ebo);
 	glBindVertexArray(model.vao);
 	glBindBuffer(GL_ARRAY_BUFFER, model.vbo);
-	glBufferData(GL_ARRAY_BUFFER, triangles.size() * sizeof(float), triangles.data(), // NOLINT(*-narrowing-conversions)
+	glBufferData(GL_ARRAY_BUFFER, model.getVertexCount() * model.getVertexSize(), model.getVertexData(), // NOLINT(*-narrowing-conversions)
+				 GL_STATIC_DRAW);
+	// The element buffer binding is VAO state: it stays bound to model.vao.
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model.ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, model.getIndexCount() * model.getIndexSize(), model.getIndexData(), // NOLINT(*-narrowing-conversions)
 				 GL_STATIC_DRAW);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), static_cast<void *>(nullptr));
+	if (model.isQuantized()) {
+		// Positions come out in [0, 1]; vertex.gls scales them back with
+		// positionOffset/positionScale.
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex),
+							  reinterpret_cast<void *>(offsetof(PackedVertex, position)));
+		glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+							  reinterpret_cast<void *>(offsetof(PackedVertex, uv)));
+		glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex),
+							  reinterpret_cast<void *>(offsetof(PackedVertex, normal)));
+	}
+	else {
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), static_cast<void *>(nullptr));
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), reinterpret_cast<void *>(3 * sizeof(float)));
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), reinterpret_cast<void *>(5 * sizeof(float)));
+	}
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void *>(3 * sizeof(float)));
 	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	glGenBuffers(1, &model.mbo);
+	glBindBuffer(GL_ARRAY_BUFFER, model.mbo);
+	glBufferData(GL_ARRAY_BUFFER, model.getVertexCount() * sizeof(uint16_t), model.getVertexMaterials(), // NOLINT(*-narrowing-conversions)
+				 GL_STATIC_DRAW);
+	glVertexAttribIPointer(3, 1, GL_UNSIGNED_SHORT, sizeof(uint16_t), static_cast<void *>(nullptr));
+	glEnableVertexAttribArray(3);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+}
+
 
-	if (!normals.empty()) {
-		glGenBuffers(1, &model.vbo_normal);
-		glBindBuffer(GL_ARRAY_BUFFER, model.vbo_normal);
-		glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), // NOLINT(*-narrowing-conversions)
-					 normals.data(), GL_STATIC_DRAW);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, model.vbo_normal);
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), static_cast<void *>(0));
+// Uploads what the loader has parsed since the last frame. Once the model
+// is complete it replaces the preview; returns false from then on.
+bool pollLoader(GLFWwindow *window, Shader &shader, Model &model, Loader &loader, glm::vec3 &center) {
+	loader.upload();
+	center = loader.getCenter();
+	if (!loader.isDone()) {
+		loader.showProgress(window);
+		return true;
 	}
+
+	Model::adoptMesh(model, loader.take());
+	createVaoVbo(model);
+	shader.setMaterial(model);
+	center = model.getCenter();
+	glfwSetWindowTitle(window, model.getName().c_str());
+	return false;
 }
 
 
-void rendererLoop(GLFWwindow *window, Shader &shader, Model &model, Camera &camera) {
+void rendererLoop(GLFWwindow *window, Shader &shader, Model &model, Camera &camera, Loader &loader,
+	MaterialBatch &materials, TextureStreamer &textures, const ViewOptions &options) {
 
 	float light = 0.1;
 	int v = 0;
-	int stopper = -1;
 	glm::vec3	color(1.33f, 1.0f, 1.06f); //blue
 	float		axis = 0.0f;
-	std::vector<float>	triangles = model.getTriangles();
+	bool		loading = true;
+	glm::vec3	objectCenter(0.0f);
+	LodState	lod;
+	bool		batched = false;
 
 	while (!glfwWindowShouldClose(window)) {
-		if (createTexture(model, stopper)) {
-			//std::cout << "Failed to create texture" << std::endl;
-			//break ;
+		if (loading) {
+			loading = pollLoader(window, shader, model, loader, objectCenter);
+			if (!loading && options.batch_materials)
+				batched = materials.build(model, shader.getId());
 		}
 
+		textures.request(static_cast<size_t>(model.tex.type));
+		model.tex.id = textures.poll();
+
 		model.matrix = Datrix(1.0f).getMatrix();
-		std::vector<float> allTriangles;
-		allTriangles.insert(allTriangles.end(), triangles.begin(), triangles.end());
-		glm::vec3 objectCenter = calculateCenter(allTriangles);
 
 		model.matrix = glm::translate(model.matrix, objectCenter);
 		model.matrix = glm::rotate(model.matrix, glm::radians(0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
@@ -115,6 +270,12 @@ void rendererLoop(GLFWwindow *window, Shader &shader, Model &model, Camera &came
 		glPolygonMode(GL_FRONT_AND_BACK, (
 			model.mode == 0) ? GL_LINE : (model.mode == 1)  ? GL_POINT : GL_FILL
 			);
+		// Wireframe and point modes keep showing the back of the model.
+		const bool backfaces = options.cull_backfaces && model.mode == 2;
+		if (backfaces)
+			glEnable(GL_CULL_FACE);
+		else
+			glDisable(GL_CULL_FACE);
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, model.tex.id);
@@ -122,48 +283,114 @@ void rendererLoop(GLFWwindow *window, Shader &shader, Model &model, Camera &came
 		glUniform1i(glGetUniformLocation(shader.getId(), "useTexture"), v);
 		glUniform1f(glGetUniformLocation(shader.getId(), "useLight"), light);
 		glUniform1i(glGetUniformLocation(shader.getId(), "texture"), 0);
+		materials.bind();
+		glUniform1i(glGetUniformLocation(shader.getId(), "materialMaps"), MATERIAL_MAP_UNIT);
+		glUniform1i(glGetUniformLocation(shader.getId(), "batchMaterials"), batched);
 		glUniform3fv(glGetUniformLocation(shader.getId(), "objectColor"),1 , &color[0]);
 
 		glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "model"), 1, GL_FALSE, &model.matrix[0][0]);
 
-		Datrix	model_matrix(1.0f);
-		Datrix	projection_matrix = Datrix(1.0f).perspective(
-			glm::radians(45.0f),
-			static_cast<float>(WINDOW_W) / static_cast<float>(WINDOW_H),
-			0.1f, 1500.0f);
+		// Quantized positions are stored relative to the mesh bounds.
+		const bool		quantized = !loading && model.isQuantized();
+		const glm::vec3	position_offset = quantized ? model.getBoundsMin() : glm::vec3(0.0f);
+		const glm::vec3	position_scale = quantized ? model.getBoundsMax() - model.getBoundsMin() : glm::vec3(1.0f);
+		glUniform3fv(glGetUniformLocation(shader.getId(), "positionOffset"), 1, &position_offset[0]);
+		glUniform3fv(glGetUniformLocation(shader.getId(), "positionScale"), 1, &position_scale[0]);
+		glUniform1f(glGetUniformLocation(shader.getId(), "lodFade"), 1.0f);
+		glUniform1i(glGetUniformLocation(shader.getId(), "lodFadeOut"), 0);
 
-		Datrix	view_matrix = camera.getView2();
-		glm::mat4 model_view_projection_matrix = projection_matrix.getMatrix() * view_matrix.getMatrix() * model_matrix.getMatrix();
+		const Datrix	model_matrix(1.0f);
+		const Datrix	view_matrix = camera.getView2();
+		// OpenGL's projection * view * model, in a single pass.
+		const Datrix	model_view_projection_matrix = model_matrix * view_matrix * PROJECTION;
 
-		glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "modelViewProjectionMatrix"), 1, GL_FALSE, &model_view_projection_matrix[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "projection"), 1, GL_FALSE, &projection_matrix.getMatrix()[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "modelViewProjectionMatrix"), 1, GL_FALSE, model_view_projection_matrix.data);
+		glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "projection"), 1, GL_FALSE, PROJECTION.data);
 
-		glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "view"), 1, GL_FALSE, &view_matrix.getMatrix()[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "view"), 1, GL_FALSE, view_matrix.data);
 
-		draw(model);
-		key(window, v, light, model, camera);
+		if (loading) {
+			loader.draw();
+			loader.drawProgress(window);
+		}
+		else {
+			ViewCull cull{};
+			frustum_planes(Datrix::convertMatrix(view_matrix * PROJECTION) * model.matrix, cull.planes);
+			cull.eye = glm::vec3(glm::inverse(model.matrix) * glm::vec4(camera.getPosition(), 1.0f));
+			cull.backfaces = backfaces;
+			drawLods(shader, model, cull, lod, batched);
+		}
+		key(window, v, light, model, camera, textures);
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 }
 
-int main(const int argc, char **argv) {
-	if (argc < 4) {
-		std::cerr << "Usage: " << argv[0] << " <file.obj> <vector shaders> <fragment shaders> [textures]" << std::endl;
+void releaseModel(Model &model) {
+	glDeleteVertexArrays(1, &model.vao);
+	glDeleteBuffers(1, &model.vbo);
+	glDeleteBuffers(1, &model.ebo);
+	glDeleteBuffers(1, &model.mbo);
+}
+
+// Takes the --options out of argv, leaving the positional arguments in
+// order. Returns false on an unknown option.
+bool parseOptions(int &argc, char **argv, LoadOptions &options, ViewOptions &view) {
+	int kept = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg(argv[i]);
+
+		if (arg.rfind("--", 0) != 0)
+			argv[kept++] = argv[i];
+		else if (arg == "--optimize")
+			options.optimize = true;
+		else if (arg == "--no-optimize")
+			options.optimize = false;
+		else if (arg == "--quantize")
+			options.quantize = true;
+		else if (arg == "--cull-backfaces")
+			view.cull_backfaces = true;
+		else if (arg == "--batch-materials")
+			view.batch_materials = true;
+		else if (arg == "--no-compress-textures")
+			view.compress_textures = false;
+		else if (arg.rfind("--texture-budget=", 0) == 0) {
+			char				*end;
+			const std::string	value = arg.substr(std::strlen("--texture-budget="));
+			const unsigned long	mib = std::strtoul(value.c_str(), &end, 10);
+
+			if (value.empty() || *end || value[0] == '-') {
+				std::cerr << "Invalid texture budget: " << value << " (MiB expected)" << std::endl;
+				return false;
+			}
+			view.texture_budget = static_cast<size_t>(mib) << 20;
+		}
+		else {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return false;
+		}
+	}
+	argv[kept] = nullptr;
+	argc = kept;
+	return true;
+}
+
+int main(int argc, char **argv) {
+	LoadOptions options;
+	ViewOptions view;
+
+	if (!parseOptions(argc, argv, options, view) || argc < 4) {
+		std::cerr << "Usage: " << argv[0] << " <file.obj> <vector shaders> <fragment shaders> [textures]"
+			<< " [--optimize | --no-optimize] [--quantize] [--cull-backfaces] [--batch-materials]"
+			<< " [--no-compress-textures] [--texture-budget=<MiB>]" << std::endl;
 		return EXIT_FAILURE;
 	}
 
 	const std::string file_path(argv[1]);
 	Model model;
 
-	try {
-		model = Model(file_path);
-		Model::loadExtenalTextures(model, argv);
-	}
-	catch (const Model::ModelException &e) {
-		std::cerr << e.what() << std::endl;
-		return EXIT_FAILURE;
-	}
+	Model::loadExtenalTextures(model, argv);
 
 	if (!glfwInit()) {
 		std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -179,35 +406,35 @@ int main(const int argc, char **argv) {
 		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	#endif
 
-	GLFWwindow *window = create_window(model);
+	// The window opens right away; the model is parsed in the background.
+	GLFWwindow *window = create_window(file_path);
 
 	try {
+		Loader loader(file_path, options);
 		Shader shader(argv[2], argv[3], model);
 		Camera camera;
+		MaterialBatch materials;
+		const std::vector<char *> &paths = model.getExternalTextures();
+		TextureStreamer textures(std::vector<std::string>(paths.begin(), paths.end()), view.compress_textures,
+			view.texture_budget);
 
-		createVaoVbo(model);
-
-		rendererLoop(window, shader, model, camera);
+		rendererLoop(window, shader, model, camera, loader, materials, textures, view);
 	}
 	// Bad shaders, exit somewhat gracefully
 	catch (Shader::ShaderException &e) {
 		std::cerr << e.what() << std::endl;
-		glDeleteVertexArrays(1, &model.vao);
-		glDeleteBuffers(1, &model.vbo);
-		if (model.vbo_normal) {
-			glDeleteBuffers(1, &model.vbo_normal);
-		}
-		glDeleteTextures(1, &model.tex.id);
+		releaseModel(model);
 		glfwTerminate();
 		return EXIT_FAILURE;
 	}
-
-	glDeleteVertexArrays(1, &model.vao);
-	glDeleteBuffers(1, &model.vbo);
-	if (model.vbo_normal) {
-		glDeleteBuffers(1, &model.vbo_normal);
+	catch (const Model::ModelException &e) {
+		std::cerr << e.what() << std::endl;
+		releaseModel(model);
+		glfwTerminate();
+		return EXIT_FAILURE;
 	}
-	glDeleteTextures(1, &model.tex.id);
+
+	releaseModel(model);
 	glfwTerminate();
 	return 0;
-}
\ No newline at end of file
+}
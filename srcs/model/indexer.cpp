@@ -0,0 +1,63 @@
+#include "../../headers/model/indexer.hpp"
+
+static inline size_t hash_corner(const Corner &c) {
+	uint64_t h = static_cast<uint32_t>(c.v) * 0x9e3779b97f4a7c15ull;
+	h ^= static_cast<uint32_t>(c.vt) * 0xc2b2ae3d27d4eb4full + (h << 6) + (h >> 2);
+	h ^= static_cast<uint32_t>(c.vn) * 0x165667b19e3779f9ull + (h << 6) + (h >> 2);
+	h ^= static_cast<uint32_t>(c.group) * 0x27d4eb2f165667c5ull + (h << 6) + (h >> 2);
+	return static_cast<size_t>(h ^ (h >> 29));
+}
+
+static inline bool same_corner(const Corner &a, const Corner &b) {
+	return a.v == b.v && a.vt == b.vt && a.vn == b.vn && a.group == b.group;
+}
+
+// Sized for `expected` distinct corners at a load factor of at most 1/2.
+CornerTable::CornerTable(const size_t expected, std::pmr::memory_resource *resource) : slots(resource) {
+	size_t capacity = 16;
+
+	while (capacity < expected * 2)
+		capacity <<= 1;
+	slots.assign(capacity, Slot{{0, 0, 0, 0}, 0});
+	mask = capacity - 1;
+}
+
+// Returns the index already given to `corner`, or gives it the next one.
+uint32_t CornerTable::findOrInsert(const Corner &corner, bool &inserted) {
+	if ((count + 1) * 2 > slots.size())
+		grow();
+	for (size_t i = hash_corner(corner) & mask;; i = (i + 1) & mask) {
+		Slot &slot = slots[i];
+
+		if (slot.key.v == 0) {
+			slot.key = corner;
+			slot.index = static_cast<uint32_t>(count++);
+			inserted = true;
+			return slot.index;
+		}
+		if (same_corner(slot.key, corner)) {
+			inserted = false;
+			return slot.index;
+		}
+	}
+}
+
+size_t CornerTable::size() const {
+	return count;
+}
+
+void CornerTable::grow() {
+	std::pmr::vector<Slot> old(slots.get_allocator());
+
+	old.swap(slots);
+	slots.assign(old.size() * 2, Slot{{0, 0, 0, 0}, 0});
+	mask = slots.size() - 1;
+	for (const Slot &slot : old) {
+		if (slot.key.v == 0)
+			continue ;
+		size_t i = hash_corner(slot.key) & mask;
+		while (slots[i].key.v != 0)
+			i = (i + 1) & mask;
+		slots[i] = slot;
+	}
+}
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <cstring>
+
+#include "../../headers/model/model.hpp"
+#include "../../headers/files/files.hpp"
+
+// .scopmesh: the post-processed mesh of an .obj, stored next to it.
+//
+//	ScopMeshHeader
+//	source path, object name		(raw bytes)
+//	dependencies					(ScopMeshDependency + path, one per .mtl)
+//	materials						(ScopMeshMaterial + name + map_Kd, in slot order)
+//	vertices						(16-byte aligned, PackedVertex or VERTEX_FLOATS floats)
+//	vertex materials				(16-byte aligned, uint16_t material slot per vertex)
+//	indices							(16-byte aligned, 16 or 32-bit triangle list,
+//									 every level of detail one after the other)
+//	submeshes						(16-byte aligned, Submesh, the levels in order)
+//	meshlets						(16-byte aligned, Meshlet, the levels in order)
+//
+// The file is written in native byte order and rejected by any build whose
+// layout differs; bump SCOPMESH_VERSION whenever the content changes.
+
+#define SCOPMESH_EXTENSION	".scopmesh"
+#define SCOPMESH_VERSION	10u
+#define SCOPMESH_BYTE_ORDER	0x01020304u
+
+struct ScopMeshHeader {
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	byte_order;
+	uint64_t	header_size;
+
+	uint64_t	source_size;
+	int64_t		source_mtime;
+	uint64_t	source_hash;
+
+	uint64_t	path_length;
+	uint64_t	name_length;
+	uint64_t	dependency_count;
+	uint64_t	material_count;
+	uint64_t	vertices_offset, vertex_count;
+	uint64_t	vertex_materials_offset;
+	uint64_t	indices_offset, index_count;
+	uint64_t	submeshes_offset, submesh_count;
+	uint64_t	meshlets_offset, meshlet_count;
+	uint32_t	index_type;
+	uint32_t	optimized;		// LoadOptions the mesh was built with
+	uint32_t	quantized;
+	uint32_t	lod_count;
+
+	float		bounds_min[3], bounds_max[3], center[3];
+	MeshLod		lods[LOD_LEVELS];
+};
+
+struct ScopMeshDependency {
+	uint64_t	size;
+	int64_t		mtime;
+	uint32_t	exists;
+	uint32_t	path_length;
+};
+
+struct ScopMeshMaterial {
+	Mtl			mtl;
+	uint32_t	name_length;
+	uint32_t	map_length;
+};
+
+static const char	SCOPMESH_MAGIC[8] = {'S', 'C', 'O', 'P', 'M', 'E', 'S', 'H'};
+
+static size_t align16(const size_t n) {
+	return (n + 15) & ~static_cast<size_t>(15);
+}
+
+// Bounds-checked cursor over the mapped cache.
+struct Reader {
+	const char	*p, *end;
+
+	bool take(void *dst, const size_t n) {
+		if (static_cast<size_t>(end - p) < n)
+			return false;
+		std::memcpy(dst, p, n);
+		p += n;
+		return true;
+	}
+
+	bool take(std::string &dst, const size_t n) {
+		if (static_cast<size_t>(end - p) < n)
+			return false;
+		dst.assign(p, n);
+		p += n;
+		return true;
+	}
+};
+
+static bool section_fits(const MappedFile &file, const uint64_t offset, const uint64_t bytes) {
+	return offset % 16 == 0 && offset <= file.size() && bytes <= file.size() - offset;
+}
+
+// Whether every index of the section names one of the vertices; they go
+// to the GPU as they are.
+template <typename Index>
+static bool indices_fit(const char *section, const uint64_t index_count, const uint64_t vertex_count) {
+	const Index *indices = reinterpret_cast<const Index *>(section);
+
+	return std::none_of(indices, indices + index_count,
+		[vertex_count](const Index index) { return index >= vertex_count; });
+}
+
+bool Model::loadCache(Model &self, const std::string &file_path) {
+	const FileStamp source = stamp_file(file_path);
+	if (!source.exists)
+		return false;
+
+	auto mapping = std::make_shared<const MappedFile>(file_path + SCOPMESH_EXTENSION);
+	if (!mapping->isOpen())
+		return false;
+
+	ScopMeshHeader				header{};
+	Reader						in{mapping->begin(), mapping->end()};
+	std::string					path, name;
+	std::vector<std::string>	dependencies;
+
+	if (!in.take(&header, sizeof(header))
+		|| std::memcmp(header.magic, SCOPMESH_MAGIC, sizeof(SCOPMESH_MAGIC)) != 0
+		|| header.version != SCOPMESH_VERSION
+		|| header.byte_order != SCOPMESH_BYTE_ORDER
+		|| header.header_size != sizeof(ScopMeshHeader)
+		|| header.optimized != self.options.optimize
+		|| header.quantized != self.options.quantize
+		|| !in.take(path, header.path_length)
+		|| !in.take(name, header.name_length))
+		return false;
+
+	// A changed .mtl invalidates the cache as surely as a changed .obj.
+	for (uint64_t i = 0; i < header.dependency_count; ++i) {
+		ScopMeshDependency	dependency{};
+		std::string			dependency_path;
+
+		if (!in.take(&dependency, sizeof(dependency)) || !in.take(dependency_path, dependency.path_length))
+			return false;
+		const FileStamp stamp = stamp_file(dependency_path);
+		if (stamp.exists != (dependency.exists != 0)
+			|| (stamp.exists && (stamp.size != dependency.size || stamp.mtime != dependency.mtime)))
+			return false;
+		dependencies.push_back(dependency_path);
+	}
+
+	std::vector<Material> materials(header.material_count);
+	for (Material &material : materials) {
+		ScopMeshMaterial record{};
+
+		if (!in.take(&record, sizeof(record)) || !in.take(material.name, record.name_length)
+			|| !in.take(material.diffuse_map, record.map_length))
+			return false;
+		material.mtl = record.mtl;
+	}
+	if (materials.empty())
+		return false;
+
+	if (header.index_type != GL_UNSIGNED_SHORT && header.index_type != GL_UNSIGNED_INT)
+		return false;
+	const size_t index_size = header.index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	const size_t vertex_size = header.quantized ? sizeof(PackedVertex) : VERTEX_FLOATS * sizeof(float);
+	if (!section_fits(*mapping, header.vertices_offset, header.vertex_count * vertex_size)
+		|| !section_fits(*mapping, header.vertex_materials_offset, header.vertex_count * sizeof(uint16_t))
+		|| !section_fits(*mapping, header.indices_offset, header.index_count * index_size)
+		|| !section_fits(*mapping, header.submeshes_offset, header.submesh_count * sizeof(Submesh))
+		|| !section_fits(*mapping, header.meshlets_offset, header.meshlet_count * sizeof(Meshlet)))
+		return false;
+	if (header.lod_count == 0 || header.lod_count > LOD_LEVELS)
+		return false;
+	for (uint32_t i = 0; i < header.lod_count; ++i)
+		if (header.lods[i].count % 3 != 0 || header.lods[i].first > header.index_count
+			|| header.lods[i].count > header.index_count - header.lods[i].first
+			|| header.lods[i].first_submesh > header.submesh_count
+			|| header.lods[i].submesh_count > header.submesh_count - header.lods[i].first_submesh)
+			return false;
+	const Submesh *submeshes = reinterpret_cast<const Submesh *>(mapping->begin() + header.submeshes_offset);
+	for (uint64_t i = 0; i < header.submesh_count; ++i)
+		if (submeshes[i].material >= materials.size()
+			|| submeshes[i].first > header.index_count || submeshes[i].count > header.index_count - submeshes[i].first
+			|| submeshes[i].first_meshlet > header.meshlet_count
+			|| submeshes[i].meshlet_count > header.meshlet_count - submeshes[i].first_meshlet)
+			return false;
+	const uint16_t *vertex_materials = reinterpret_cast<const uint16_t *>(mapping->begin() + header.vertex_materials_offset);
+	if (std::any_of(vertex_materials, vertex_materials + header.vertex_count,
+			[&materials](const uint16_t material) { return material >= materials.size(); }))
+		return false;
+	const char *indices = mapping->begin() + header.indices_offset;
+	if (header.index_type == GL_UNSIGNED_SHORT
+			? !indices_fit<uint16_t>(indices, header.index_count, header.vertex_count)
+			: !indices_fit<uint32_t>(indices, header.index_count, header.vertex_count))
+		return false;
+	const Meshlet *meshlets = reinterpret_cast<const Meshlet *>(mapping->begin() + header.meshlets_offset);
+	for (uint64_t i = 0; i < header.meshlet_count; ++i)
+		if (meshlets[i].first % 3 != 0 || meshlets[i].count % 3 != 0
+			|| meshlets[i].first > header.index_count || meshlets[i].count > header.index_count - meshlets[i].first)
+			return false;
+
+	// Same path, size and mtime is trusted as is. Anything else only has to
+	// agree on the content: a touched or copied .obj keeps its cache.
+	bool refresh = false;
+	if (path != file_path || source.size != header.source_size || source.mtime != header.source_mtime) {
+		if (source.size != header.source_size)
+			return false;
+		const MappedFile content(file_path);
+		if (!content.isOpen() || hash_file(content) != header.source_hash)
+			return false;
+		refresh = true;
+	}
+
+	self.cache = mapping;
+	self.name = name;
+	self.materials = std::move(materials);
+	self.material_files = dependencies;
+	self.bounds_min = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+	self.bounds_max = glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]);
+	self.center = glm::vec3(header.center[0], header.center[1], header.center[2]);
+	self.quantized = header.quantized;
+	self.cached_vertices = mapping->begin() + header.vertices_offset;
+	self.cached_vertex_count = header.vertex_count;
+	self.cached_vertex_materials = vertex_materials;
+	self.cached_indices = indices;
+	self.cached_index_count = header.index_count;
+	self.index_type = header.index_type;
+	self.lods.assign(header.lods, header.lods + header.lod_count);
+	self.submeshes.assign(submeshes, submeshes + header.submesh_count);
+	self.cached_meshlets = meshlets;
+	self.cached_meshlet_count = header.meshlet_count;
+
+	if (refresh)
+		saveCache(self, file_path);
+
+	if constexpr (DEBUG) {
+		std::cout << "Mesh loaded from " << file_path << SCOPMESH_EXTENSION << std::endl;
+	}
+	return true;
+}
+
+void Model::saveCache(const Model &self, const std::string &file_path) {
+	const MappedFile	content(file_path);
+	const FileStamp		source = stamp_file(file_path);
+
+	if (!content.isOpen() || !source.exists)
+		return ;
+
+	ScopMeshHeader header{};
+	std::memcpy(header.magic, SCOPMESH_MAGIC, sizeof(SCOPMESH_MAGIC));
+	header.version = SCOPMESH_VERSION;
+	header.byte_order = SCOPMESH_BYTE_ORDER;
+	header.header_size = sizeof(ScopMeshHeader);
+	header.source_size = source.size;
+	header.source_mtime = source.mtime;
+	header.source_hash = hash_file(content);
+	header.path_length = file_path.size();
+	header.name_length = self.name.size();
+	header.dependency_count = self.material_files.size();
+	header.material_count = self.materials.size();
+	header.optimized = self.options.optimize;
+	header.quantized = self.quantized;
+	header.lod_count = static_cast<uint32_t>(self.lods.size());
+	std::copy(self.lods.begin(), self.lods.end(), header.lods);
+	for (int i = 0; i < 3; ++i) {
+		header.bounds_min[i] = self.bounds_min[i];
+		header.bounds_max[i] = self.bounds_max[i];
+		header.center[i] = self.center[i];
+	}
+
+	std::vector<ScopMeshDependency>	dependencies;
+	for (const std::string &dependency : self.material_files) {
+		const FileStamp stamp = stamp_file(dependency);
+		dependencies.push_back({stamp.size, stamp.mtime, stamp.exists, static_cast<uint32_t>(dependency.size())});
+	}
+
+	std::vector<ScopMeshMaterial>	materials;
+	for (const Material &material : self.materials)
+		materials.push_back({material.mtl, static_cast<uint32_t>(material.name.size()),
+			static_cast<uint32_t>(material.diffuse_map.size())});
+
+	// parts only keeps pointers: the section offsets stored in the header
+	// below are still picked up when the file is written.
+	std::vector<std::pair<const void *, size_t>> parts;
+	size_t offset = 0;
+	auto push = [&parts, &offset](const void *data, const size_t size) {
+		parts.emplace_back(data, size);
+		offset += size;
+	};
+	static const char padding[16] = {};
+	auto align = [&push, &offset]() {
+		push(padding, align16(offset) - offset);
+	};
+
+	push(&header, sizeof(header));
+	push(file_path.data(), file_path.size());
+	push(self.name.data(), self.name.size());
+	for (size_t i = 0; i < dependencies.size(); ++i) {
+		push(&dependencies[i], sizeof(ScopMeshDependency));
+		push(self.material_files[i].data(), self.material_files[i].size());
+	}
+	for (size_t i = 0; i < materials.size(); ++i) {
+		push(&materials[i], sizeof(ScopMeshMaterial));
+		push(self.materials[i].name.data(), self.materials[i].name.size());
+		push(self.materials[i].diffuse_map.data(), self.materials[i].diffuse_map.size());
+	}
+	align();
+	header.vertices_offset = offset;
+	header.vertex_count = self.getVertexCount();
+	push(self.getVertexData(), header.vertex_count * self.getVertexSize());
+	align();
+	header.vertex_materials_offset = offset;
+	push(self.getVertexMaterials(), header.vertex_count * sizeof(uint16_t));
+	align();
+	header.indices_offset = offset;
+	header.index_count = self.getIndexCount();
+	header.index_type = self.getIndexType();
+	push(self.getIndexData(), header.index_count * self.getIndexSize());
+	align();
+	header.submeshes_offset = offset;
+	header.submesh_count = self.submeshes.size();
+	push(self.submeshes.data(), header.submesh_count * sizeof(Submesh));
+	align();
+	header.meshlets_offset = offset;
+	header.meshlet_count = self.getMeshletCount();
+	push(self.getMeshlets(), header.meshlet_count * sizeof(Meshlet));
+
+	if (!write_file_atomic(file_path + SCOPMESH_EXTENSION, parts)) {
+		if constexpr (DEBUG) {
+			std::cout << "Could not write " << file_path << SCOPMESH_EXTENSION << std::endl;
+		}
+	}
+}
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cmath>
+
+#include "../../headers/model/meshlet.hpp"
+
+#if defined(__SSE__) || defined(_M_X64)
+# include <xmmintrin.h>
+# define MESHLET_SSE 1
+#else
+# define MESHLET_SSE 0
+#endif
+
+static glm::vec3 vertex_position(const std::vector<float> &buffer, const size_t stride, const uint32_t v) {
+	return glm::vec3(buffer[v * stride], buffer[v * stride + 1], buffer[v * stride + 2]);
+}
+
+// Sphere around the bounding box of the vertices, and the narrowest cone
+// around the average triangle normal that holds every triangle normal.
+static Meshlet meshlet_bounds(const std::vector<uint32_t> &indices, const size_t begin, const size_t end,
+	const std::vector<float> &buffer, const size_t stride) {
+	glm::vec3	low = vertex_position(buffer, stride, indices[begin]), high = low;
+	glm::vec3	sum(0.0f);
+	float		radius = 0.0f, min_dot = 1.0f;
+	Meshlet		meshlet{};
+
+	for (size_t i = begin; i < end; ++i) {
+		const glm::vec3 p = vertex_position(buffer, stride, indices[i]);
+		low = glm::min(low, p);
+		high = glm::max(high, p);
+	}
+	const glm::vec3 center = (low + high) * 0.5f;
+	for (size_t i = begin; i < end; ++i)
+		radius = std::max(radius, glm::length(vertex_position(buffer, stride, indices[i]) - center));
+
+	std::vector<glm::vec3> normals;
+	normals.reserve((end - begin) / 3);
+	for (size_t i = begin; i < end; i += 3) {
+		const glm::vec3	a = vertex_position(buffer, stride, indices[i]);
+		const glm::vec3	n = glm::cross(vertex_position(buffer, stride, indices[i + 1]) - a,
+							vertex_position(buffer, stride, indices[i + 2]) - a);
+		const float		length = glm::length(n);
+
+		if (length > 0.0f) {
+			normals.push_back(n / length);
+			sum += normals.back();
+		}
+	}
+	const float length = glm::length(sum);
+	const glm::vec3 axis = length > 0.0f ? sum / length : glm::vec3(0.0f);
+	for (const glm::vec3 &n : normals)
+		min_dot = std::min(min_dot, glm::dot(n, axis));
+
+	for (int c = 0; c < 3; ++c) {
+		meshlet.center[c] = center[c];
+		meshlet.axis[c] = axis[c];
+	}
+	meshlet.radius = radius;
+	meshlet.cutoff = length > 0.0f && min_dot > 0.0f ? std::sqrt(1.0f - min_dot * min_dot) : 1.0f;
+	meshlet.first = static_cast<uint32_t>(begin);
+	meshlet.count = static_cast<uint32_t>(end - begin);
+	return meshlet;
+}
+
+void build_meshlets(std::vector<uint32_t> &indices, const size_t first, const size_t count,
+	const std::vector<float> &buffer, const size_t stride, std::vector<Meshlet> &out) {
+	const size_t	triangles = count / 3;
+	const size_t	vertices = buffer.size() / stride;
+	const uint32_t	*source = indices.data() + first;
+	const size_t	first_meshlet = out.size();
+
+	if (triangles == 0)
+		return ;
+
+	// Triangles around each position: vertices split by a UV or normal seam
+	// still join their neighbours.
+	std::vector<uint32_t> welded(vertices), by_position(vertices);
+	for (size_t v = 0; v < vertices; ++v)
+		by_position[v] = static_cast<uint32_t>(v);
+	auto less = [&buffer, stride](const uint32_t a, const uint32_t b) {
+		return std::lexicographical_compare(&buffer[a * stride], &buffer[a * stride] + 3,
+			&buffer[b * stride], &buffer[b * stride] + 3);
+	};
+	std::sort(by_position.begin(), by_position.end(), less);
+	for (size_t i = 0; i < vertices; ++i)
+		welded[by_position[i]] = i > 0 && !less(by_position[i - 1], by_position[i])
+			? welded[by_position[i - 1]] : by_position[i];
+
+	std::vector<uint32_t> offsets(vertices + 1, 0);
+	for (size_t i = 0; i < count; ++i)
+		++offsets[welded[source[i]] + 1];
+	for (size_t v = 0; v < vertices; ++v)
+		offsets[v + 1] += offsets[v];
+	std::vector<uint32_t> around(count), cursor(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < count; ++i)
+		around[cursor[welded[source[i]]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<glm::vec3> normal(triangles);
+	for (size_t t = 0; t < triangles; ++t) {
+		const glm::vec3	a = vertex_position(buffer, stride, source[t * 3]);
+		const glm::vec3	n = glm::cross(vertex_position(buffer, stride, source[t * 3 + 1]) - a,
+							vertex_position(buffer, stride, source[t * 3 + 2]) - a);
+		const float		length = glm::length(n);
+		normal[t] = length > 0.0f ? n / length : glm::vec3(0.0f);
+	}
+
+	std::vector<bool>		used(triangles, false);
+	std::vector<uint32_t>	order, candidates, seen(triangles, 0);
+	uint32_t				id = 0;
+	size_t					seed = 0;
+
+	order.reserve(triangles);
+	while (order.size() < triangles) {
+		const size_t	begin = order.size();
+		glm::vec3		sum(0.0f);
+
+		while (used[seed])
+			++seed;
+		candidates.assign(1, static_cast<uint32_t>(seed));
+		++id;
+		for (size_t size = 0; size < MESHLET_MAX_TRIANGLES; ++size) {
+			const float		spread = glm::length(sum);
+			const glm::vec3	axis = spread > 0.0f ? sum / spread : glm::vec3(0.0f);
+			float			best_score = -2.0f;
+			size_t			best = 0;
+
+			if (candidates.empty())
+				break ;
+			for (size_t c = 0; c < candidates.size(); ++c) {
+				const glm::vec3	&n = normal[candidates[c]];
+				const float		score = n.x * axis.x + n.y * axis.y + n.z * axis.z;
+				if (score > best_score) {
+					best_score = score;
+					best = c;
+				}
+			}
+			if (size >= MESHLET_MIN_TRIANGLES && best_score < MESHLET_CONE_COS)
+				break ;
+
+			const uint32_t t = candidates[best];
+			candidates[best] = candidates.back();
+			candidates.pop_back();
+			used[t] = true;
+			order.push_back(t);
+			sum += normal[t];
+			for (int c = 0; c < 3; ++c) {
+				const uint32_t v = welded[source[t * 3 + c]];
+				for (uint32_t k = offsets[v]; k < offsets[v + 1]; ++k)
+					if (!used[around[k]] && seen[around[k]] != id) {
+						seen[around[k]] = id;
+						candidates.push_back(around[k]);
+					}
+			}
+		}
+		// Back to the order the triangles came in, tuned for the vertex cache.
+		std::sort(order.begin() + static_cast<std::ptrdiff_t>(begin), order.end());
+		out.push_back({{}, 0.0f, {}, 0.0f, static_cast<uint32_t>(first + begin * 3),
+			static_cast<uint32_t>((order.size() - begin) * 3)});
+	}
+
+	std::vector<uint32_t> sorted(count);
+	for (size_t t = 0; t < triangles; ++t)
+		for (int c = 0; c < 3; ++c)
+			sorted[t * 3 + c] = source[order[t] * 3 + c];
+	std::copy(sorted.begin(), sorted.end(), indices.begin() + static_cast<std::ptrdiff_t>(first));
+	for (size_t m = first_meshlet; m < out.size(); ++m)
+		out[m] = meshlet_bounds(indices, out[m].first, out[m].first + out[m].count, buffer, stride);
+}
+
+void frustum_planes(const glm::mat4 &clip, glm::vec4 planes[6]) {
+	const glm::vec4 row[4] = {
+		glm::vec4(clip[0][0], clip[1][0], clip[2][0], clip[3][0]),
+		glm::vec4(clip[0][1], clip[1][1], clip[2][1], clip[3][1]),
+		glm::vec4(clip[0][2], clip[1][2], clip[2][2], clip[3][2]),
+		glm::vec4(clip[0][3], clip[1][3], clip[2][3], clip[3][3]),
+	};
+
+	for (int axis = 0; axis < 3; ++axis) {
+		planes[axis * 2] = row[3] + row[axis];
+		planes[axis * 2 + 1] = row[3] - row[axis];
+	}
+	for (int i = 0; i < 6; ++i)
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+// Back-facing when every direction from the eye into the bounding sphere
+// makes an angle of less than 90 degrees with every normal of the cone.
+static bool meshlet_visible(const Meshlet &meshlet, const glm::vec4 planes[6], const glm::vec3 &eye,
+	const bool backfaces) {
+	const glm::vec3 center(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+
+	for (int i = 0; i < 6; ++i)
+		if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -meshlet.radius)
+			return false;
+	if (backfaces) {
+		const glm::vec3 direction = center - eye;
+		const glm::vec3 axis(meshlet.axis[0], meshlet.axis[1], meshlet.axis[2]);
+		if (glm::dot(direction, axis) >= meshlet.cutoff * glm::length(direction) + meshlet.radius)
+			return false;
+	}
+	return true;
+}
+
+#if MESHLET_SSE
+
+// Four meshlets at a time: two transposes turn their bounds into one
+// register per field, and every test runs on the four lanes at once.
+static size_t cull_meshlets_ps(const Meshlet *meshlets, const size_t first, const size_t end,
+	const glm::vec4 planes[6], const glm::vec3 &eye, const bool backfaces, std::vector<uint32_t> &visible) {
+	const __m128	zero = _mm_setzero_ps();
+	size_t			i = first;
+
+	for (; i + 4 <= end; i += 4) {
+		__m128 cx = _mm_loadu_ps(meshlets[i].center), cy = _mm_loadu_ps(meshlets[i + 1].center);
+		__m128 cz = _mm_loadu_ps(meshlets[i + 2].center), radius = _mm_loadu_ps(meshlets[i + 3].center);
+		_MM_TRANSPOSE4_PS(cx, cy, cz, radius);
+		const __m128 below = _mm_sub_ps(zero, radius);
+		__m128 culled = zero;
+
+		for (int p = 0; p < 6; ++p) {
+			const __m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), cx), _mm_mul_ps(_mm_set1_ps(planes[p].y), cy)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), cz), _mm_set1_ps(planes[p].w)));
+			culled = _mm_or_ps(culled, _mm_cmplt_ps(distance, below));
+		}
+		if (backfaces) {
+			__m128 ax = _mm_loadu_ps(meshlets[i].axis), ay = _mm_loadu_ps(meshlets[i + 1].axis);
+			__m128 az = _mm_loadu_ps(meshlets[i + 2].axis), cutoff = _mm_loadu_ps(meshlets[i + 3].axis);
+			_MM_TRANSPOSE4_PS(ax, ay, az, cutoff);
+			const __m128 dx = _mm_sub_ps(cx, _mm_set1_ps(eye.x));
+			const __m128 dy = _mm_sub_ps(cy, _mm_set1_ps(eye.y));
+			const __m128 dz = _mm_sub_ps(cz, _mm_set1_ps(eye.z));
+			const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+			const __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ax), _mm_mul_ps(dy, ay)), _mm_mul_ps(dz, az));
+			culled = _mm_or_ps(culled, _mm_cmpge_ps(along, _mm_add_ps(_mm_mul_ps(cutoff, length), radius)));
+		}
+
+		const int mask = _mm_movemask_ps(culled);
+		for (int lane = 0; lane < 4; ++lane)
+			if (!(mask & (1 << lane)))
+				visible.push_back(static_cast<uint32_t>(i + lane));
+	}
+	return i;
+}
+
+#endif
+
+void cull_meshlets(const Meshlet *meshlets, const size_t first, const size_t count, const glm::vec4 planes[6],
+	const glm::vec3 &eye, const bool backfaces, std::vector<uint32_t> &visible) {
+	size_t i = first;
+
+#if MESHLET_SSE
+	i = cull_meshlets_ps(meshlets, first, first + count, planes, eye, backfaces, visible);
+#endif
+	for (; i < first + count; ++i)
+		if (meshlet_visible(meshlets[i], planes, eye, backfaces))
+			visible.push_back(static_cast<uint32_t>(i));
+}
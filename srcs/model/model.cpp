@@ -1,42 +1,90 @@
+#include <algorithm>
+#include <cctype>
 #include <cmath>
 
+#include "../../headers/arena/arena.hpp"
 #include "../../headers/model/model.hpp"
+#include "../../headers/model/indexer.hpp"
+#include "../../headers/model/normals.hpp"
+#include "../../headers/model/optimizer.hpp"
+#include "../../headers/model/parser.hpp"
+#include "../../headers/model/simplify.hpp"
+#include "../../headers/pool/pool.hpp"
 
 // UTILS
 
-void load_vertex(Model &model, std::istringstream &stream) {
-	Vertex vertex{};
+// Appends every chunk's records at its prefix-sum offset in the destination.
+template <typename T>
+static void merge_into(std::vector<T> &dst, std::vector<ObjChunk> &chunks, std::pmr::vector<T> ObjChunk::*member) {
+	std::vector<size_t> offsets(chunks.size() + 1, dst.size());
+
+	for (size_t i = 0; i < chunks.size(); ++i)
+		offsets[i + 1] = offsets[i] + (chunks[i].*member).size();
+	dst.resize(offsets.back());
+	ThreadPool::shared().parallelFor(chunks.size(), [&](size_t i) {
+		const std::pmr::vector<T> &src = chunks[i].*member;
+		std::copy(src.begin(), src.end(), dst.begin() + static_cast<std::ptrdiff_t>(offsets[i]));
+	});
+}
 
-	stream >> vertex.x >> vertex.y >> vertex.z;
-	vertex.texX = vertex.x;
-	vertex.texY = vertex.y;
-	Model::pushVertices(model, vertex);
+// Appends every chunk's faces, shifting their offsets by the corners merged
+// before them. `group` and `material` are the smoothing group and material
+// slot in effect after the faces already in dst; they are carried into the
+// chunks that start without an `s` or a `usemtl`.
+static void merge_faces(FaceList &dst, std::vector<ObjChunk> &chunks, int &group, int &material) {
+	std::vector<size_t>	faces(chunks.size() + 1, dst.size());
+	std::vector<size_t>	corners(chunks.size() + 1, dst.vertices.size());
+	std::vector<int>	incoming(chunks.size()), incoming_material(chunks.size());
+
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		faces[i + 1] = faces[i] + chunks[i].faces.size();
+		corners[i + 1] = corners[i] + chunks[i].faces.vertices.size();
+		incoming[i] = group;
+		incoming_material[i] = material;
+		if (chunks[i].group != SMOOTHING_INHERIT)
+			group = chunks[i].group;
+		if (chunks[i].material != MATERIAL_INHERIT)
+			material = chunks[i].material_slots[chunks[i].material];
+	}
+	dst.offsets.resize(faces.back() + 1);
+	dst.groups.resize(faces.back());
+	dst.materials.resize(faces.back());
+	dst.vertices.resize(corners.back());
+	dst.textures.resize(corners.back());
+	dst.normals.resize(corners.back());
+	ThreadPool::shared().parallelFor(chunks.size(), [&](size_t i) {
+		const FaceList			&src = chunks[i].faces;
+		const std::ptrdiff_t	at = static_cast<std::ptrdiff_t>(corners[i]);
+
+		std::copy(src.vertices.begin(), src.vertices.end(), dst.vertices.begin() + at);
+		std::copy(src.textures.begin(), src.textures.end(), dst.textures.begin() + at);
+		std::copy(src.normals.begin(), src.normals.end(), dst.normals.begin() + at);
+		for (size_t f = 0; f < src.size(); ++f) {
+			dst.offsets[faces[i] + f + 1] = static_cast<uint32_t>(corners[i] + src.offsets[f + 1]);
+			dst.groups[faces[i] + f] = src.groups[f] == SMOOTHING_INHERIT ? incoming[i] : src.groups[f];
+			dst.materials[faces[i] + f] = src.materials[f] == MATERIAL_INHERIT
+				? incoming_material[i] : chunks[i].material_slots[src.materials[f]];
+		}
+	});
 }
 
-void load_faces(Model &model, std::istringstream &stream) {
-	int i = 0, j = 0;
-	bool slash = false;
+// Spherical projection used for vertices without texture coordinates.
+static void spherical_uv(const Vertex &vertex, float &u, float &v) {
+	const float theta = std::atan2(vertex.z, vertex.x);
+	const float phi =
+		acos(vertex.y / std::sqrt(vertex.x * vertex.x + vertex.y * vertex.y + vertex.z * vertex.z));
+	u = (theta + M_PI) / (2.0f * M_PI);
+	v = phi / M_PI;
+}
 
-	std::vector<int> faces, uvs;
+// Runs tipsify over indices[first, first + count).
+static void tipsify_range(std::vector<uint32_t> &indices, const size_t first, const size_t count,
+	const std::vector<float> &buffer) {
+	const auto				begin = indices.begin() + static_cast<std::ptrdiff_t>(first);
+	std::vector<uint32_t>	range(begin, begin + static_cast<std::ptrdiff_t>(count));
 
-	while (stream >> i) {
-		faces.push_back(i);
-		if (stream.peek() == '/') {
-			slash = true;
-			stream.ignore();
-			stream >> j;
-			uvs.push_back(j);
-			stream.ignore(256, ' ');
-		} else
-			stream.ignore(256, ' ');
-	}
-	if (faces.size() >= 3) {
-		Model::pushFaces(model, faces);
-		if (slash == true) Model::pushTexturesIndices(model, uvs);
-		model.setSlash(slash);
-	}
-	else
-		throw Model::CreationError("Too many indexes: " + std::to_string(faces.size()));
+	tipsify(range, buffer, VERTEX_FLOATS);
+	std::copy(range.begin(), range.end(), begin);
 }
 
 // ---------------------------------------------
@@ -45,7 +93,8 @@ void load_faces(Model &model, std::istringstream &stream) {
 Model::Model() {
 	vao = 0;
 	vbo = 0;
-	vbo_normal = 0;
+	ebo = 0;
+	mbo = 0;
 
 	light_source = glm::vec3(LIGHT_POS_X, LIGHT_POS_Y, LIGHT_POS_Z);
 
@@ -54,18 +103,32 @@ Model::Model() {
 	}
 }
 
-Model::Model(const std::string &file_path) {
+Model::Model(const std::string &file_path, LoadProgress *progress, const LoadOptions &options) {
 	vao = 0;
 	vbo = 0;
-	vbo_normal = 0;
+	ebo = 0;
+	mbo = 0;
 
 	light_source = glm::vec3(LIGHT_POS_X, LIGHT_POS_Y, LIGHT_POS_Z);
-
-	loadModel(*this, file_path);
-	normalizeCoords(*this);
-	triangleCreator(*this);
-	filter(*this);
-	squaredTriangles(*this);
+	this->options = options;
+
+	if (!loadCache(*this, file_path)) {
+		loadModel(*this, file_path, progress);
+		normalizeCoords(*this);
+		triangleCreator(*this);
+		triangulate(*this);
+		splitMaterialSeams(*this);
+		if (options.optimize)
+			optimizeMesh(*this);
+		buildLods(*this);
+		buildMeshlets(*this);
+		assignVertexMaterials(*this);
+		packIndices(*this);
+		computeBounds(*this);
+		if (options.quantize)
+			quantizeVertices(*this);
+		saveCache(*this, file_path);
+	}
 
 	if constexpr (DEBUG) {
 		std::cout << "Model created" << std::endl;
@@ -73,57 +136,88 @@ Model::Model(const std::string &file_path) {
 }
 
 
-void Model::loadModel(Model &self, const std::string &file_path) {
+// Chunks are parsed in waves of one chunk per thread. Without a progress
+// sink there is a single wave; with one, the triangles of every wave are
+// published before the next wave starts. Each chunk allocates from its own
+// arena, dropped in one go once the wave is merged.
+void Model::loadModel(Model &self, const std::string &file_path, LoadProgress *progress) {
 
 	if constexpr (DEBUG) {
 		std::cout << "Loading model from file..." << std::endl;
 	}
 
-	std::string line;
-	std::ifstream ofile(file_path);
-	bool mtl_loaded = false;
+	const MappedFile	ofile(file_path);
+	bool				mtl_loaded = false;
 
-	if (!ofile.is_open()) {
+	if (!ofile.isOpen()) {
 		throw FileError(file_path);
 	}
 
-	while (std::getline(ofile, line)) {
-		std::string prefix;
-		std::istringstream stream(line);
-		float normalX, normalY, normalZ;
+	std::vector<const char *>	bounds;
+	split_chunks(ofile.begin(), ofile.end(), bounds);
+	const size_t				total = bounds.size() - 1;
+	const size_t				wave = progress ? ThreadPool::shared().size() : total;
 
-		stream >> prefix;
-		if (prefix == "o") {
-			stream >> self.name;
-		}
-		else if (prefix == "mtllib") {
-			loadMaterialDefinitions(self, stream, prefix, file_path);
-			mtl_loaded = true;
-		}
-		else if (prefix == "v") {
-			load_vertex(self, stream);
-		}
-		else if (prefix == "vn") {
-			stream >> normalX >> normalY >> normalZ;
-			self.normals.emplace_back(normalX, normalY, normalZ);
-		}
-		else if (prefix == "vt") {
-			UV uvVal{};
-			stream >> uvVal.u >> uvVal.v >> uvVal.w;
-			self.textures.push_back(uvVal);
+	for (size_t first = 0; first < total; first += wave) {
+		const size_t					count = std::min(wave, total - first);
+		std::unique_ptr<LoadArena[]>	arenas(new LoadArena[count]);
+		std::vector<ObjChunk>			chunks;
+		const size_t					first_face = self.faces.size();
+
+		chunks.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+			chunks.emplace_back(&arenas[i]);
+
+		ThreadPool::shared().parallelFor(chunks.size(), [&](size_t i) {
+			try {
+				parse_chunk(bounds[first + i], bounds[first + i + 1], chunks[i]);
+			}
+			catch (...) {
+				chunks[i].error = std::current_exception();
+			}
+		});
+		for (const ObjChunk &chunk : chunks)
+			if (chunk.error)
+				std::rethrow_exception(chunk.error);
+
+		merge_into(self.vertices, chunks, &ObjChunk::vertices);
+		merge_into(self.textures, chunks, &ObjChunk::textures);
+		merge_into(self.normals, chunks, &ObjChunk::normals);
+		for (ObjChunk &chunk : chunks)
+			for (const ObjDirective &directive : chunk.directives)
+				if (directive.kind == ObjDirective::USEMTL)
+					chunk.material_slots.push_back(materialSlot(self, std::string(directive.argument)));
+		merge_faces(self.faces, chunks, self.smoothing, self.material_slot);
+
+		for (const ObjChunk &chunk : chunks) {
+			self.c += chunk.faces_count;
+			if (chunk.last_slash >= 0)
+				self.slash = chunk.last_slash;
+			for (const ObjDirective &directive : chunk.directives) {
+				if (directive.kind == ObjDirective::NAME)
+					self.name = std::string(directive.argument);
+				else if (directive.kind == ObjDirective::MTLLIB) {
+					if (!directive.argument.empty())
+						loadMaterialDefinitions(self, std::string(directive.argument));
+					mtl_loaded = true;
+				}
+			}
 		}
-		else if (prefix == "f") {
-			self.c++;
-			load_faces(self, stream);
+
+		if (progress) {
+			if (progress->cancelled())
+				throw CreationError("loading cancelled");
+			std::vector<float> preview;
+			previewTriangles(self, first_face, preview);
+			progress->batch(std::move(preview), static_cast<float>(bounds[first + chunks.size()] - ofile.begin())
+				/ static_cast<float>(std::max<size_t>(1, ofile.size())));
 		}
 	}
 
 	if (!mtl_loaded) {
-		std::istringstream stream(std::string("default.mtl"));
-		std::string tmp;
-		loadMaterialDefinitions(self, stream, tmp, "file_path");
+		loadMaterialDefinitions(self, "default.mtl");
 	}
-	ofile.close();
+	resolveMaterials(self);
 
 	if constexpr (DEBUG) {
 		std::cout << "Done." << std::endl;
@@ -150,178 +244,507 @@ Model &Model::pushVertices(Model &self, Vertex &vertex) {
 	return self;
 }
 
-Model &Model::pushFaces(Model &self, std::vector<int> &faces) {
-	self.faces.push_back(faces);
+// Appends a face without texture coordinates or normals.
+Model &Model::pushFaces(Model &self, const std::vector<int> &faces) {
+	self.faces.vertices.insert(self.faces.vertices.end(), faces.begin(), faces.end());
+	self.faces.textures.resize(self.faces.vertices.size(), 0);
+	self.faces.normals.resize(self.faces.vertices.size(), 0);
+	self.faces.offsets.push_back(static_cast<uint32_t>(self.faces.vertices.size()));
+	self.faces.groups.push_back(self.smoothing);
+	self.faces.materials.push_back(self.material_slot);
 
 	return self;
 }
 
-Model &Model::pushTexturesIndices(Model &self, std::vector<int> &indices) {
-	self.textures_indices.push_back(indices);
+// Sets the texture coordinates of the last face pushed.
+Model &Model::pushTexturesIndices(Model &self, const std::vector<int> &indices) {
+	if (self.faces.size() == 0)
+		return self;
+
+	const size_t	first = self.faces.offsets[self.faces.size() - 1];
+	const size_t	count = std::min(indices.size(), self.faces.textures.size() - first);
+
+	std::copy(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(count), self.faces.textures.begin() + static_cast<std::ptrdiff_t>(first));
 
 	return self;
 }
 
 // DOC: https://people.sc.fsu.edu/~jburkardt/data/mtl/mtl.html
 // MORE DOC: http://www.paulbourke.net/dataformats/mtl/
-void Model::loadMaterialDefinitions(
-	Model &self, std::istringstream &stream, std::string &prefix, std::string file_path
-	)
-{
-	stream >> file_path;
+void Model::loadMaterialDefinitions(Model &self, const std::string &file_path) {
 	std::string file = "./resources/" + file_path;
 	std::ifstream mfile(file);
 
+	self.material_files.push_back(file);
+
 	if (mfile.is_open()) {
-		std::string mline;
+		std::string mline, prefix;
 
 		while (std::getline(mfile, mline)) {
 			std::istringstream sstream(mline);
+			prefix.clear();
 			sstream >> prefix;
+			if (prefix == "newmtl") {
+				self.material_library.emplace_back();
+				sstream >> self.material_library.back().name;
+				continue ;
+			}
+			if (prefix.empty() || prefix[0] == '#')
+				continue ;
+			// Statements before the first newmtl describe an unnamed material.
+			if (self.material_library.empty())
+				self.material_library.emplace_back();
+			Material &material = self.material_library.back();
+
 			if (prefix == "Ka") {
-				sstream >> self.material.ka.r >> self.material.ka.g >> self.material.ka.b;
+				sstream >> material.mtl.ka.r >> material.mtl.ka.g >> material.mtl.ka.b;
 			}
 			else if (prefix == "Kd")
-				sstream >> self.material.kd.r >> self.material.kd.g >> self.material.kd.b;
+				sstream >> material.mtl.kd.r >> material.mtl.kd.g >> material.mtl.kd.b;
 			else if (prefix == "Ks")
-				sstream >> self.material.ks.r >> self.material.ks.g >> self.material.ks.b;
+				sstream >> material.mtl.ks.r >> material.mtl.ks.g >> material.mtl.ks.b;
 			else if (prefix == "d")
-				sstream >> self.material.d;
+				sstream >> material.mtl.d;
 			else if (prefix == "Tr")
-				sstream >> self.material.tr;
+				sstream >> material.mtl.tr;
 			else if (prefix == "Ns")
-				sstream >> self.material.ns;
+				sstream >> material.mtl.ns;
 			else if (prefix== "Ni")
-				sstream >> self.material.ni;
+				sstream >> material.mtl.ni;
 			else if (prefix == "illum")
-				sstream >> self.material.illum;
+				sstream >> material.mtl.illum;
+			else if (prefix == "map_Kd") {
+				std::getline(sstream >> std::ws, material.diffuse_map);
+				while (!material.diffuse_map.empty() && std::isspace(static_cast<unsigned char>(material.diffuse_map.back())))
+					material.diffuse_map.pop_back();
+				// Absolute paths, Windows ones included, are kept as written.
+				const std::string &map = material.diffuse_map;
+				if (!map.empty() && map[0] != '/' && map[0] != '\\' && (map.size() < 2 || map[1] != ':'))
+					material.diffuse_map.insert(0, file.substr(0, file.find_last_of('/') + 1));
+			}
 		}
 		mfile.close();
 	} else
 		std::cerr << "Error opening the file: " << file << std::endl;
 }
 
+// Slot of the material a `usemtl` names, added on first use. Slot 0 holds
+// the faces that come before any usemtl.
+int Model::materialSlot(Model &self, const std::string &name) {
+	for (size_t i = 1; i < self.materials.size(); ++i)
+		if (self.materials[i].name == name)
+			return static_cast<int>(i);
+	self.materials.emplace_back();
+	self.materials.back().name = name;
+	return static_cast<int>(self.materials.size() - 1);
+}
+
+// Fills every slot from the .mtl files read. A name they do not define, and
+// slot 0, get the first material defined, as the whole model did when it
+// had a single material.
+void Model::resolveMaterials(Model &self) {
+	for (size_t i = 0; i < self.materials.size(); ++i) {
+		Material	&slot = self.materials[i];
+		auto		found = std::find_if(self.material_library.begin(), self.material_library.end(),
+						[&slot](const Material &material) { return material.name == slot.name; });
+
+		if (i == 0 || found == self.material_library.end()) {
+			if (i > 0)
+				std::cerr << "Material " << slot.name << " is not defined." << std::endl;
+			found = self.material_library.begin();
+		}
+		if (found != self.material_library.end()) {
+			slot.mtl = found->mtl;
+			slot.diffuse_map = found->diffuse_map;
+		}
+	}
+	std::vector<Material>().swap(self.material_library);
+}
+
 void Model::normalizeCoords(Model &self) {
 	if constexpr (DEBUG) {
 		std::cout << "Normalizing vertices..." << std::endl;
 	}
-	for (auto &vertex : self.vertices) {
-		const float theta = std::atan2(vertex.z, vertex.x);
-		const float phi =
-			acos(vertex.y / std::sqrt(vertex.x * vertex.x + vertex.y * vertex.y + vertex.z * vertex.z));
-		vertex.texX = (theta + M_PI) / (2.0f * M_PI);
-		vertex.texY = phi / M_PI;
-	}
+	for (auto &vertex : self.vertices)
+		spherical_uv(vertex, vertex.texX, vertex.texY);
 	if constexpr (DEBUG) {
 		std::cout << "Done." << std::endl;
 	}
 }
 
+// Every face corner is looked up by its (v, vt, vn) triple: corners that
+// share all three share one entry of vertex_buffer, and polygons only keep
+// indices into it. Corners without vn get a generated normal: the average of
+// the faces around them in the same smoothing group, or the face normal when
+// smoothing is off, which keeps such corners apart from their neighbours.
 void Model::triangleCreator(Model &self) {
 	if constexpr (DEBUG) {
 		std::cout << "Load triangles..." << std::endl;
 	}
-	if (self.slash == true) {
-		for (long unsigned int i = 0; i < self.faces.size(); ++i) {
-			const std::vector<int> &face = self.faces[i];
-			const std::vector<int> &texture_index = self.textures_indices[i];
-
-			if (face.size() >= 3 && texture_index.size() >= 3) {
-				std::vector<Vertex> triangle;
-				for (long unsigned int j = 0; j < face.size(); ++j) {
-					int x = face[j], y = texture_index[j];
-					if (y > 0 && y <= static_cast<int>(self.textures.size())) {
-						self.vertices[x - 1].texX = self.textures[y - 1].u;
-						self.vertices[x - 1].texY = self.textures[y - 1].v;
-					}
-					triangle.push_back(self.vertices[x - 1]);
-				}
-				self.trigon.push_back(triangle);
-			} else
-				std::cerr << "Invalid face with less than 3 indices encountered. Ignoring.\n";
+	const int					vertex_count = static_cast<int>(self.vertices.size());
+	const int					texture_count = static_cast<int>(self.textures.size());
+	const int					normal_count = static_cast<int>(self.normals.size());
+	LoadArena					arena;			// scratch, released on return
+	std::pmr::vector<uint32_t>	unlit(&arena);	// vertices whose corners had no vn
+
+	CornerTable	table(std::max({self.vertices.size(), self.textures.size(), self.normals.size()}), &arena);
+
+	self.polygon_offsets.assign(1, 0);
+	self.polygon_offsets.reserve(self.faces.size() + 1);
+	self.polygon_materials.reserve(self.faces.size());
+	self.polygon_corners.reserve(self.faces.vertices.size());
+	self.vertex_buffer.reserve(self.vertices.size() * VERTEX_FLOATS);
+	const FaceList	&faces = self.faces;
+	for (size_t f = 0; f < faces.size(); ++f) {
+		const size_t	begin = faces.offsets[f], end = faces.offsets[f + 1];
+
+		if (end - begin < 3) {
+			std::cerr << "Invalid face with less than 3 indices encountered. Ignoring.\n";
+			continue ;
 		}
-	}
-	else
-		for (const std::vector<int> &face : self.faces) {
-			if (face.size() >= 3) {
-				std::vector<Vertex> triangle;
-				for (int i : face) {
-					if (!self.textures.empty()) {
-						self.vertices[i - 1].texX = self.textures[i - 1].u;
-						self.vertices[i - 1].texY = self.textures[i - 1].v;
-					}
-					triangle.push_back(self.vertices[i - 1]);
-				}
-				self.trigon.push_back(triangle);
+		if (std::any_of(&faces.vertices[begin], &faces.vertices[end], [vertex_count](int x) { return x < 1 || x > vertex_count; })) {
+			std::cerr << "Invalid face with out of range indices encountered. Ignoring.\n";
+			continue ;
+		}
+
+		for (size_t k = begin; k < end; ++k) {
+			Corner	corner{faces.vertices[k], faces.textures[k], faces.normals[k], 0};
+			bool	inserted;
+
+			// Files without any slash pair each v with the vt of the same index.
+			if (!self.slash && texture_count)
+				corner.vt = corner.v;
+			if (corner.vt < 1 || corner.vt > texture_count)
+				corner.vt = 0;
+			if (corner.vn < 1 || corner.vn > normal_count)
+				corner.vn = 0;
+			if (!corner.vn)
+				corner.group = faces.groups[f] == SMOOTHING_OFF ? -1 - static_cast<int>(f) : faces.groups[f];
+
+			const uint32_t index = table.findOrInsert(corner, inserted);
+			if (inserted) {
+				const Vertex	&vertex = self.vertices[corner.v - 1];
+				const float		u = corner.vt ? self.textures[corner.vt - 1].u : vertex.texX;
+				const float		v = corner.vt ? self.textures[corner.vt - 1].v : vertex.texY;
+				const glm::vec3	n = corner.vn ? self.normals[corner.vn - 1] : glm::vec3(0.0f);
+
+				self.vertex_buffer.insert(self.vertex_buffer.end(), {vertex.x, vertex.y, vertex.z, u, v, n.x, n.y, n.z});
+				if (!corner.vn)
+					unlit.push_back(index);
 			}
-			else
-				std::cerr << "Invalid face with less than 3 indices encountered. Ignoring.\n";
+			self.polygon_corners.push_back(index);
 		}
+		self.polygon_offsets.push_back(static_cast<uint32_t>(self.polygon_corners.size()));
+		self.polygon_materials.push_back(static_cast<uint32_t>(faces.materials[f]));
+	}
+
+	generate_normals(self.vertex_buffer, self.polygon_offsets, self.polygon_corners, unlit, &arena);
+	self.faces = FaceList();
 	if constexpr (DEBUG) {
-		std::cout << "Triangles loaded." << std::endl;
+		std::cout << "Triangles loaded: " << table.size() << " distinct vertices for "
+			<< self.polygon_corners.size() << " corners." << std::endl;
 	}
 }
 
 
-void Model::filter(Model &self) {
-	for (const auto &shape : self.trigon) {
-		if (shape.size() == 3) {
-			for (const auto &vertex : shape) {
-				self.Triangles.push_back(vertex.x);
-				self.Triangles.push_back(vertex.y);
-				self.Triangles.push_back(vertex.z);
-				self.Triangles.push_back(vertex.texX);
-				self.Triangles.push_back(vertex.texY);
+// Same triangles as triangleCreator/triangulate would build for
+// faces[first_face..], minus faces that use vertices not parsed yet. They are
+// only shown while loading and may come in a different order.
+void Model::previewTriangles(const Model &self, const size_t first_face, std::vector<float> &out) {
+	const int vertex_count = static_cast<int>(self.vertices.size());
+	const int texture_count = static_cast<int>(self.textures.size());
+	const int normal_count = static_cast<int>(self.normals.size());
+
+	for (size_t i = first_face; i < self.faces.size(); ++i) {
+		const size_t	begin = self.faces.offsets[i];
+		const size_t	size = self.faces.offsets[i + 1] - begin;
+		const int		*face = &self.faces.vertices[begin];
+		const int		*uvs = &self.faces.textures[begin];
+		const int		*vns = &self.faces.normals[begin];
+		bool			has_normals = true;
+		glm::vec3		flat(0.0f);
+
+		if (size < 3 || std::any_of(face, face + size, [vertex_count](int x) { return x < 1 || x > vertex_count; }))
+			continue ;
+		for (size_t j = 0; j < size; ++j) {
+			const Vertex	&a = self.vertices[face[j] - 1];
+			const Vertex	&b = self.vertices[face[(j + 1) % size] - 1];
+
+			has_normals = has_normals && vns[j] > 0 && vns[j] <= normal_count;
+			flat.x += (a.y - b.y) * (a.z + b.z);
+			flat.y += (a.z - b.z) * (a.x + b.x);
+			flat.z += (a.x - b.x) * (a.y + b.y);
+		}
+		// Flat shading until the final mesh averages the missing normals.
+		if (glm::length(flat) > 0.0f)
+			flat = glm::normalize(flat);
+
+		auto emit = [&](const size_t j) {
+			Vertex		corner = self.vertices[face[j] - 1];
+			const int	y = self.slash ? uvs[j] : face[j];
+			glm::vec3	normal = flat;
+
+			if (y > 0 && y <= texture_count) {
+				corner.texX = self.textures[y - 1].u;
+				corner.texY = self.textures[y - 1].v;
 			}
+			else
+				spherical_uv(corner, corner.texX, corner.texY);
+			if (has_normals)
+				normal = self.normals[vns[j] - 1];
+			out.insert(out.end(), {corner.x, corner.y, corner.z, corner.texX, corner.texY, normal.x, normal.y, normal.z});
+		};
+		for (size_t t = 1; t + 1 < size; ++t) {
+			emit(0);
+			emit(t);
+			emit(t + 1);
 		}
-		else if (shape.size() == 4) {
-			for (const auto &vertex : shape) {
-				self.Squares.push_back(vertex.x);
-				self.Squares.push_back(vertex.y);
-				self.Squares.push_back(vertex.z);
-				self.Squares.push_back(vertex.texX);
-				self.Squares.push_back(vertex.texY);
+	}
+}
+
+// Fans every polygon into the triangle list, grouped by material. A polygon
+// of n corners writes n - 2 triangles; blocks of polygons count theirs per
+// material in parallel, a scan over the (material, block) totals gives each
+// block its output offset for every material, and the blocks are then
+// written in parallel. Each material keeps the file order of its triangles
+// and becomes one submesh of level 0.
+void Model::triangulate(Model &self) {
+	ThreadPool					&pool = ThreadPool::shared();
+	const std::vector<uint32_t>	&offsets = self.polygon_offsets;
+	const size_t				polygons = offsets.empty() ? 0 : offsets.size() - 1;
+	const size_t				blocks = std::min(polygons, static_cast<size_t>(pool.size()) * 4);
+	const size_t				materials = self.materials.size();
+	std::vector<size_t>			first(materials * blocks + 1, 0);	// triangles before (material, block)
+
+	auto block_begin = [polygons, blocks](size_t b) { return polygons * b / blocks; };
+
+	pool.parallelFor(blocks, [&](size_t b) {
+		for (size_t p = block_begin(b); p < block_begin(b + 1); ++p)
+			first[self.polygon_materials[p] * blocks + b + 1] += offsets[p + 1] - offsets[p] - 2;
+	});
+	for (size_t i = 0; i < materials * blocks; ++i)
+		first[i + 1] += first[i];
+	self.Triangles.resize(first.back() * 3);
+
+	pool.parallelFor(blocks, [&](size_t b) {
+		std::vector<uint32_t *> out(materials);
+
+		for (size_t m = 0; m < materials; ++m)
+			out[m] = self.Triangles.data() + first[m * blocks + b] * 3;
+		for (size_t p = block_begin(b); p < block_begin(b + 1); ++p) {
+			const uint32_t	*polygon = &self.polygon_corners[offsets[p]];
+			const uint32_t	size = offsets[p + 1] - offsets[p];
+			uint32_t		*&to = out[self.polygon_materials[p]];
+
+			for (uint32_t t = 1; t + 1 < size; ++t) {
+				*to++ = polygon[0];
+				*to++ = polygon[t];
+				*to++ = polygon[t + 1];
 			}
 		}
+	});
+
+	self.submeshes.clear();
+	for (size_t m = 0; m < materials; ++m) {
+		const size_t begin = first[m * blocks], end = first[(m + 1) * blocks];
+		if (end > begin)
+			self.submeshes.push_back({static_cast<uint32_t>(m), static_cast<uint32_t>(begin * 3),
+				static_cast<uint32_t>((end - begin) * 3), 0, 0});
+	}
+	std::vector<uint32_t>().swap(self.polygon_corners);
+	std::vector<uint32_t>().swap(self.polygon_offsets);
+	std::vector<uint32_t>().swap(self.polygon_materials);
+}
+
+// A vertex used by faces of two materials is copied for the second one, so
+// every vertex belongs to a single material and can carry its slot. Only
+// level 0 exists yet; the coarser ones are built from its submeshes.
+void Model::splitMaterialSeams(Model &self) {
+	const size_t			vertices = self.vertex_buffer.size() / VERTEX_FLOATS;
+	std::vector<uint32_t>	owner(vertices, UINT32_MAX), copy(vertices, UINT32_MAX), copied;
+	size_t					copies = 0;
+
+	for (const Submesh &submesh : self.submeshes) {
+		for (size_t i = submesh.first; i < submesh.first + submesh.count; ++i) {
+			uint32_t &index = self.Triangles[i];
+
+			if (owner[index] == UINT32_MAX)
+				owner[index] = submesh.material;
+			if (owner[index] == submesh.material)
+				continue ;
+			if (copy[index] == UINT32_MAX) {
+				const size_t at = self.vertex_buffer.size();
+				self.vertex_buffer.resize(at + VERTEX_FLOATS);
+				std::copy_n(self.vertex_buffer.begin() + index * VERTEX_FLOATS, VERTEX_FLOATS, self.vertex_buffer.begin() + at);
+				copy[index] = static_cast<uint32_t>(at / VERTEX_FLOATS);
+				copied.push_back(index);
+			}
+			index = copy[index];
+		}
+		copies += copied.size();
+		for (const uint32_t v : copied)
+			copy[v] = UINT32_MAX;
+		copied.clear();
+	}
+
+	if constexpr (DEBUG) {
+		if (copies)
+			std::cout << "Vertices copied between materials: " << copies << std::endl;
+	}
+}
+
+// Triangle order for the post-transform cache and overdraw, then vertex
+// order for fetch locality. Cache figures are simulated for VCACHE_SIZE
+// entries.
+void Model::optimizeMesh(Model &self) {
+	const size_t	vertices = self.vertex_buffer.size() / VERTEX_FLOATS;
+	CacheStats		before{};
+
+	if constexpr (DEBUG)
+		before = cache_stats(self.Triangles, vertices);
+
+	for (const Submesh &submesh : self.submeshes)
+		tipsify_range(self.Triangles, submesh.first, submesh.count, self.vertex_buffer);
+	reorder_vertices(self.Triangles, self.vertex_buffer, VERTEX_FLOATS);
+
+	if constexpr (DEBUG) {
+		const CacheStats after = cache_stats(self.Triangles, vertices);
+		std::cout << "Mesh optimized: ACMR " << before.acmr << " -> " << after.acmr
+			<< ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+	}
+}
+
+// Each level halves the triangles of every submesh of the previous one and
+// is appended to the index list; the edges between two materials are
+// borders, so they stay in place. Errors add up from level to level, as each
+// is simplified from the one before.
+void Model::buildLods(Model &self) {
+	std::vector<Submesh>	level(self.submeshes), coarser;
+	std::vector<uint32_t>	part, next, indices;
+	float					error = 0.0f;
+
+	self.lods.assign(1, {0, static_cast<uint32_t>(self.Triangles.size()), 0.0f,
+		0, static_cast<uint32_t>(self.submeshes.size())});
+	while (self.lods.size() < LOD_LEVELS) {
+		const size_t	first = self.Triangles.size();
+		size_t			before = 0;
+		float			worst = 0.0f;
+
+		coarser.clear();
+		indices.clear();
+		for (const Submesh &submesh : level) {
+			part.assign(self.Triangles.begin() + submesh.first, self.Triangles.begin() + submesh.first + submesh.count);
+			worst = std::max(worst, simplify(part, self.vertex_buffer, VERTEX_FLOATS, part.size() / 6, next));
+			before += part.size();
+			if (next.empty())
+				continue ;
+			if (self.options.optimize)
+				tipsify(next, self.vertex_buffer, VERTEX_FLOATS);
+			coarser.push_back({submesh.material, static_cast<uint32_t>(first + indices.size()),
+				static_cast<uint32_t>(next.size()), 0, 0});
+			indices.insert(indices.end(), next.begin(), next.end());
+		}
+		if (indices.empty() || static_cast<float>(indices.size()) > static_cast<float>(before) * LOD_MIN_RATIO)
+			break ;
+		error += worst;
+		self.lods.push_back({static_cast<uint32_t>(first), static_cast<uint32_t>(indices.size()), error,
+			static_cast<uint32_t>(self.submeshes.size()), static_cast<uint32_t>(coarser.size())});
+		self.submeshes.insert(self.submeshes.end(), coarser.begin(), coarser.end());
+		self.Triangles.insert(self.Triangles.end(), indices.begin(), indices.end());
+		level.swap(coarser);
+	}
+
+	if constexpr (DEBUG) {
+		std::cout << "Levels of detail:";
+		for (const MeshLod &lod : self.lods)
+			std::cout << " " << lod.count / 3 << " (" << lod.error << ")";
+		std::cout << std::endl;
+	}
+}
+
+// Meshlets are built per submesh and reorder its triangles, trading a
+// little of the vertex cache order for tight bounds to cull.
+void Model::buildMeshlets(Model &self) {
+	self.meshlets.clear();
+	for (Submesh &submesh : self.submeshes) {
+		submesh.first_meshlet = static_cast<uint32_t>(self.meshlets.size());
+		build_meshlets(self.Triangles, submesh.first, submesh.count, self.vertex_buffer, VERTEX_FLOATS, self.meshlets);
+		submesh.meshlet_count = static_cast<uint32_t>(self.meshlets.size()) - submesh.first_meshlet;
+	}
+
+	if constexpr (DEBUG) {
+		const std::vector<uint32_t> full(self.Triangles.begin(), self.Triangles.begin() + self.lods[0].count);
+		std::cout << "Meshlets: " << self.meshlets.size() << ", ACMR "
+			<< cache_stats(full, self.vertex_buffer.size() / VERTEX_FLOATS).acmr << std::endl;
 	}
 }
 
-void Model::squaredTriangles(Model &self) {
-	std::vector<float> triangles;
-
-	for (size_t i = 0; i < self.Squares.size(); i += 20) {
-		if (self.Squares.empty()) break;
-		float x1 = self.Squares[i];
-		float y1 = self.Squares[i + 1];
-		float z1 = self.Squares[i + 2];
-		float texX1 = self.Squares[i + 3];
-		float texY1 = self.Squares[i + 4];
-
-		float x2 = self.Squares[i + 5];
-		float y2 = self.Squares[i + 6];
-		float z2 = self.Squares[i + 7];
-		float texX2 = self.Squares[i + 8];
-		float texY2 = self.Squares[i + 9];
-
-		float x3 = self.Squares[i + 10];
-		float y3 = self.Squares[i + 11];
-		float z3 = self.Squares[i + 12];
-		float texX3 = self.Squares[i + 13];
-		float texY3 = self.Squares[i + 14];
-
-		float x4 = self.Squares[i + 15];
-		float y4 = self.Squares[i + 16];
-		float z4 = self.Squares[i + 17];
-		float texX4 = self.Squares[i + 18];
-		float texY4 = self.Squares[i + 19];
-
-		self.Triangles.insert(self.Triangles.end(), {x1, y1, z1, texX1, texY1, x2, y2, z2, texX2, texY2, x3,
-										   y3, z3, texX3, texY3});
-		self.Triangles.insert(self.Triangles.end(), {x1, y1, z1, texX1, texY1, x3, y3, z3, texX3, texY3, x4,
-										   y4, z4, texX4, texY4});
+// Material slot of every vertex, read back from the submeshes once the
+// vertices have their final order.
+void Model::assignVertexMaterials(Model &self) {
+	self.vertex_materials.assign(self.vertex_buffer.size() / VERTEX_FLOATS, 0);
+	for (const Submesh &submesh : self.submeshes)
+		for (size_t i = submesh.first; i < submesh.first + submesh.count; ++i)
+			self.vertex_materials[self.Triangles[i]] = static_cast<uint16_t>(submesh.material);
+}
+
+// Meshes with at most 65536 distinct vertices are drawn with 16-bit indices.
+void Model::packIndices(Model &self) {
+	if (self.vertex_buffer.size() / VERTEX_FLOATS > 65536) {
+		self.index_type = GL_UNSIGNED_INT;
+		return ;
 	}
+	self.index_type = GL_UNSIGNED_SHORT;
+	self.short_indices.assign(self.Triangles.begin(), self.Triangles.end());
+	std::vector<uint32_t>().swap(self.Triangles);
 }
 
+void Model::computeBounds(Model &self) {
+	const float		*data = self.vertex_buffer.data();
+	const size_t	size = self.vertex_buffer.size();
+	glm::vec3		sum(0.0f);
+
+	if (size == 0) {
+		self.bounds_min = self.bounds_max = self.center = glm::vec3(0.0f);
+		return ;
+	}
+	self.bounds_min = self.bounds_max = glm::vec3(data[0], data[1], data[2]);
+	for (size_t i = 0; i < size; i += VERTEX_FLOATS) {
+		const glm::vec3 p(data[i], data[i + 1], data[i + 2]);
+		self.bounds_min = glm::min(self.bounds_min, p);
+		self.bounds_max = glm::max(self.bounds_max, p);
+		sum += p;
+	}
+	self.center = sum / static_cast<float>(size / VERTEX_FLOATS);
+}
+
+// Replaces the float vertices by PackedVertex, half the size. Positions are
+// relative to the bounds, which vertex.gls gets back as uniforms.
+void Model::quantizeVertices(Model &self) {
+	const QuantizationError error = quantize_vertices(self.vertex_buffer, self.bounds_min, self.bounds_max, self.packed_vertices);
+
+	std::vector<float>().swap(self.vertex_buffer);
+	self.quantized = true;
+	if constexpr (DEBUG) {
+		std::cout << "Vertices quantized: max error " << error.position << " (position), "
+			<< error.uv << " (uv), " << error.normal << " degrees (normal)" << std::endl;
+	}
+}
+
+// Keeps the viewer state of `self` (GL handles, display mode, textures) and
+// takes everything describing the mesh from `loaded`.
+void Model::adoptMesh(Model &self, Model &&loaded) {
+	loaded.vao = self.vao;
+	loaded.vbo = self.vbo;
+	loaded.ebo = self.ebo;
+	loaded.mbo = self.mbo;
+	loaded.mode = self.mode;
+	loaded.matrix = self.matrix;
+	loaded.light_source = self.light_source;
+	loaded.tex = self.tex;
+	loaded.external_textures = std::move(self.external_textures);
+	self = std::move(loaded);
+}
 
 bool Model::getSlash() const {
 	return slash;
@@ -337,17 +760,112 @@ void Model::loadExtenalTextures(Model &self, char **paths) {
 }
 
 Mtl Model::getMtl() const {
-	return material;
+	return materials[0].mtl;
+}
+
+size_t Model::getMaterialCount() const {
+	return materials.size();
+}
+
+const Material &Model::getMaterial(const size_t material) const {
+	return materials[material];
+}
+
+const void *Model::getVertexData() const {
+	if (cache)
+		return cached_vertices;
+	if (quantized)
+		return packed_vertices.data();
+	return vertex_buffer.data();
+}
+
+size_t Model::getVertexCount() const {
+	if (cache)
+		return cached_vertex_count;
+	return quantized ? packed_vertices.size() : vertex_buffer.size() / VERTEX_FLOATS;
+}
+
+size_t Model::getVertexSize() const {
+	return quantized ? sizeof(PackedVertex) : VERTEX_FLOATS * sizeof(float);
+}
+
+bool Model::isQuantized() const {
+	return quantized;
+}
+
+const uint16_t *Model::getVertexMaterials() const {
+	if (cache)
+		return cached_vertex_materials;
+	return vertex_materials.data();
+}
+
+const void *Model::getIndexData() const {
+	if (cache)
+		return cached_indices;
+	if (index_type == GL_UNSIGNED_SHORT)
+		return short_indices.data();
+	return Triangles.data();
+}
+
+size_t Model::getIndexCount() const {
+	if (cache)
+		return cached_index_count;
+	return index_type == GL_UNSIGNED_SHORT ? short_indices.size() : Triangles.size();
+}
+
+size_t Model::getLodCount() const {
+	return lods.size();
+}
+
+const MeshLod &Model::getLod(const size_t level) const {
+	return lods[level];
+}
+
+const Meshlet *Model::getMeshlets() const {
+	if (cache)
+		return cached_meshlets;
+	return meshlets.data();
+}
+
+size_t Model::getMeshletCount() const {
+	if (cache)
+		return cached_meshlet_count;
+	return meshlets.size();
+}
+
+const Submesh &Model::getSubmesh(const size_t submesh) const {
+	return submeshes[submesh];
+}
+
+const Submesh *Model::findSubmesh(const size_t level, const size_t material) const {
+	const MeshLod &lod = lods[level];
+
+	for (size_t i = lod.first_submesh; i < lod.first_submesh + lod.submesh_count; ++i)
+		if (submeshes[i].material == material)
+			return &submeshes[i];
+	return nullptr;
+}
+
+GLenum Model::getIndexType() const {
+	return index_type;
+}
+
+size_t Model::getIndexSize() const {
+	return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+glm::vec3 Model::getBoundsMin() const {
+	return bounds_min;
 }
 
-std::vector<float>	Model::getTriangles() const {
-	return Triangles;
+glm::vec3 Model::getBoundsMax() const {
+	return bounds_max;
 }
 
-std::vector<glm::vec3> Model::getNormals() const {
-	return normals;
+glm::vec3 Model::getCenter() const {
+	return center;
 }
 
-std::vector<char *>	Model::getExternalTextures() const {
+const std::vector<char *>	&Model::getExternalTextures() const {
 	return external_textures;
 }
\ No newline at end of file
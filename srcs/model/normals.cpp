@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+
+#include "../../headers/model/model.hpp"
+#include "../../headers/model/normals.hpp"
+#include "../../headers/pool/pool.hpp"
+
+#if defined(__SSE__) || defined(_M_X64)
+# include <xmmintrin.h>
+# define NORMALS_SSE 1
+#else
+# define NORMALS_SSE 0
+#endif
+
+#if NORMALS_SSE
+
+// a.yzx * b.zxy - a.zxy * b.yzx with three shuffles; the w lane is ignored.
+static inline __m128 cross_ps(const __m128 a, const __m128 b) {
+	const __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// Sum of the fan triangle cross products: twice the area of the polygon,
+// along its normal. Each vertex starts with x, y, z, so one unaligned load
+// brings the position in (the fourth lane holds u and is never used).
+static glm::vec3 face_normal(const float *buffer, const uint32_t *polygon, const size_t size) {
+	const __m128	origin = _mm_loadu_ps(buffer + polygon[0] * VERTEX_FLOATS);
+	__m128			previous = _mm_sub_ps(_mm_loadu_ps(buffer + polygon[1] * VERTEX_FLOATS), origin);
+	__m128			sum = _mm_setzero_ps();
+	float			out[4];
+
+	for (size_t j = 2; j < size; ++j) {
+		const __m128 current = _mm_sub_ps(_mm_loadu_ps(buffer + polygon[j] * VERTEX_FLOATS), origin);
+
+		sum = _mm_add_ps(sum, cross_ps(previous, current));
+		previous = current;
+	}
+	_mm_storeu_ps(out, sum);
+	return glm::vec3(out[0], out[1], out[2]);
+}
+
+#else
+
+static glm::vec3 face_normal(const float *buffer, const uint32_t *polygon, const size_t size) {
+	const float	*o = buffer + polygon[0] * VERTEX_FLOATS;
+	const float	*p = buffer + polygon[1] * VERTEX_FLOATS;
+	glm::vec3	origin(o[0], o[1], o[2]);
+	glm::vec3	previous = glm::vec3(p[0], p[1], p[2]) - origin;
+	glm::vec3	sum(0.0f);
+
+	for (size_t j = 2; j < size; ++j) {
+		const float		*c = buffer + polygon[j] * VERTEX_FLOATS;
+		const glm::vec3	current = glm::vec3(c[0], c[1], c[2]) - origin;
+
+		sum += glm::cross(previous, current);
+		previous = current;
+	}
+	return sum;
+}
+
+#endif
+
+void generate_normals(std::vector<float> &buffer, const std::vector<uint32_t> &offsets,
+	const std::vector<uint32_t> &corners, const std::pmr::vector<uint32_t> &generated,
+	std::pmr::memory_resource *arena) {
+	ThreadPool		&pool = ThreadPool::shared();
+	const size_t	polygons = offsets.empty() ? 0 : offsets.size() - 1;
+	const size_t	blocks = static_cast<size_t>(pool.size()) * 4;
+	const uint32_t	none = UINT32_MAX;
+
+	if (generated.empty() || polygons == 0)
+		return ;
+
+	std::pmr::vector<glm::vec3>	faces(polygons, arena);
+	const size_t				face_blocks = std::min(blocks, polygons);
+	pool.parallelFor(face_blocks, [&](size_t b) {
+		for (size_t p = polygons * b / face_blocks; p < polygons * (b + 1) / face_blocks; ++p)
+			faces[p] = face_normal(buffer.data(), &corners[offsets[p]], offsets[p + 1] - offsets[p]);
+	});
+
+	// Polygons around each generated vertex, in compressed sparse row form.
+	std::pmr::vector<uint32_t> rank(buffer.size() / VERTEX_FLOATS, none, arena);
+	for (size_t i = 0; i < generated.size(); ++i)
+		rank[generated[i]] = static_cast<uint32_t>(i);
+
+	std::pmr::vector<uint32_t> first(generated.size() + 1, 0, arena);
+	for (const uint32_t corner : corners)
+		if (rank[corner] != none)
+			++first[rank[corner] + 1];
+	for (size_t i = 0; i < generated.size(); ++i)
+		first[i + 1] += first[i];
+
+	std::pmr::vector<uint32_t> around(first.back(), arena);
+	std::pmr::vector<uint32_t> cursor(first.begin(), first.end() - 1, arena);
+	for (size_t p = 0; p < polygons; ++p)
+		for (uint32_t k = offsets[p]; k < offsets[p + 1]; ++k)
+			if (rank[corners[k]] != none)
+				around[cursor[rank[corners[k]]]++] = static_cast<uint32_t>(p);
+
+	const size_t vertex_blocks = std::min(blocks, generated.size());
+	pool.parallelFor(vertex_blocks, [&](size_t b) {
+		for (size_t i = generated.size() * b / vertex_blocks; i < generated.size() * (b + 1) / vertex_blocks; ++i) {
+			glm::vec3	normal(0.0f);
+			float		*n = &buffer[generated[i] * VERTEX_FLOATS + 5];
+
+			for (uint32_t k = first[i]; k < first[i + 1]; ++k)
+				normal += faces[around[k]];
+			if (glm::length(normal) > 0.0f)
+				normal = glm::normalize(normal);
+			n[0] = normal.x;
+			n[1] = normal.y;
+			n[2] = normal.z;
+		}
+	});
+}
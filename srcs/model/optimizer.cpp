@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <numeric>
+
+#include <glm/glm.hpp>
+
+#include "../../headers/model/optimizer.hpp"
+
+CacheStats cache_stats(const std::vector<uint32_t> &indices, const size_t vertex_count, const size_t cache_size) {
+	std::vector<size_t>	stamp(vertex_count, 0);		// miss that brought the vertex in, 0 if never
+	size_t				misses = 0, used = 0;
+
+	for (const uint32_t v : indices) {
+		if (stamp[v] == 0)
+			++used;
+		if (stamp[v] == 0 || misses - stamp[v] >= cache_size)
+			stamp[v] = ++misses;
+	}
+	if (indices.empty())
+		return {0.0f, 0.0f};
+	return {static_cast<float>(misses) / static_cast<float>(indices.size() / 3),
+		static_cast<float>(misses) / static_cast<float>(used)};
+}
+
+namespace {
+
+struct Cluster {
+	size_t	begin, end;		// triangles
+	float	key;
+};
+
+}
+
+void tipsify(std::vector<uint32_t> &indices, const std::vector<float> &buffer, const size_t stride,
+	const size_t cache_size) {
+	const size_t	triangles = indices.size() / 3;
+	const size_t	vertices = buffer.size() / stride;
+	const long		k = static_cast<long>(cache_size);
+
+	if (triangles == 0)
+		return ;
+
+	// Triangles around each vertex, and how many of them are still to emit.
+	std::vector<uint32_t> first(vertices + 1, 0), live(vertices, 0);
+	for (const uint32_t v : indices)
+		++live[v];
+	for (size_t v = 0; v < vertices; ++v)
+		first[v + 1] = first[v] + live[v];
+	std::vector<uint32_t> around(indices.size()), cursor(first.begin(), first.end() - 1);
+	for (size_t t = 0; t < triangles; ++t)
+		for (int c = 0; c < 3; ++c)
+			around[cursor[indices[t * 3 + c]]++] = static_cast<uint32_t>(t);
+
+	std::vector<long>		cached(vertices, 0);	// time each vertex entered the cache
+	std::vector<bool>		emitted(triangles, false);
+	std::vector<uint32_t>	dead_ends, candidates, order;
+	std::vector<size_t>		cuts{0};				// cluster starts, in emitted triangles
+	long					time = k + 1;
+	size_t					scan = 0;
+	long					fan = 0;
+
+	order.reserve(triangles);
+	dead_ends.reserve(indices.size());
+	while (fan >= 0) {
+		candidates.clear();
+		for (uint32_t a = first[fan]; a < first[fan + 1]; ++a) {
+			const uint32_t t = around[a];
+
+			if (emitted[t])
+				continue ;
+			emitted[t] = true;
+			order.push_back(t);
+			for (int c = 0; c < 3; ++c) {
+				const uint32_t v = indices[t * 3 + c];
+
+				dead_ends.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - cached[v] > k)
+					cached[v] = time++;
+			}
+		}
+
+		// Next fanning vertex: the candidate that stays in the cache the
+		// longest while its remaining triangles are emitted.
+		long best = -1, best_score = -1;
+		for (const uint32_t v : candidates) {
+			if (live[v] == 0)
+				continue ;
+			long score = 0;
+			if (time - cached[v] + 2 * static_cast<long>(live[v]) <= k)
+				score = time - cached[v];
+			if (score > best_score) {
+				best_score = score;
+				best = v;
+			}
+		}
+		if (best >= 0) {
+			fan = best;
+			continue ;
+		}
+
+		// Dead end: fall back on recently used vertices, then on the input
+		// order. The cache has lost its locality here, so a cluster ends.
+		fan = -1;
+		while (!dead_ends.empty() && fan < 0) {
+			const uint32_t v = dead_ends.back();
+			dead_ends.pop_back();
+			if (live[v] > 0)
+				fan = v;
+		}
+		while (fan < 0 && scan < vertices) {
+			if (live[scan] > 0)
+				fan = static_cast<long>(scan);
+			++scan;
+		}
+		if (order.size() > cuts.back())
+			cuts.push_back(order.size());
+	}
+	if (cuts.back() != order.size())
+		cuts.push_back(order.size());
+
+	// Outward clusters first: the larger dot(centroid - centre, normal), the
+	// more likely the cluster occludes the rest of the mesh.
+	auto position = [&buffer, stride](uint32_t v) {
+		return glm::vec3(buffer[v * stride], buffer[v * stride + 1], buffer[v * stride + 2]);
+	};
+	glm::vec3 centre(0.0f);
+	for (const uint32_t v : indices)
+		centre += position(v);
+	centre /= static_cast<float>(indices.size());
+
+	std::vector<Cluster> clusters;
+	for (size_t c = 0; c + 1 < cuts.size(); ++c) {
+		glm::vec3 centroid(0.0f), normal(0.0f);
+
+		for (size_t i = cuts[c]; i < cuts[c + 1]; ++i) {
+			const uint32_t	*tri = &indices[order[i] * 3];
+			const glm::vec3	a = position(tri[0]), b = position(tri[1]), d = position(tri[2]);
+
+			centroid += a + b + d;
+			normal += glm::cross(b - a, d - a);
+		}
+		centroid /= static_cast<float>((cuts[c + 1] - cuts[c]) * 3);
+		if (glm::length(normal) > 0.0f)
+			normal = glm::normalize(normal);
+		clusters.push_back({cuts[c], cuts[c + 1], glm::dot(centroid - centre, normal)});
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) {
+		return a.key > b.key;
+	});
+
+	std::vector<uint32_t> sorted;
+	sorted.reserve(indices.size());
+	for (const Cluster &cluster : clusters)
+		for (size_t i = cluster.begin; i < cluster.end; ++i)
+			sorted.insert(sorted.end(), &indices[order[i] * 3], &indices[order[i] * 3] + 3);
+	indices.swap(sorted);
+}
+
+void reorder_vertices(std::vector<uint32_t> &indices, std::vector<float> &buffer, const size_t stride) {
+	const size_t			vertices = buffer.size() / stride;
+	const uint32_t			none = UINT32_MAX;
+	std::vector<uint32_t>	remap(vertices, none);
+	std::vector<float>		moved(buffer.size());
+	uint32_t				next = 0;
+
+	for (uint32_t &v : indices) {
+		if (remap[v] == none) {
+			remap[v] = next;
+			std::copy_n(&buffer[v * stride], stride, &moved[next * stride]);
+			++next;
+		}
+		v = remap[v];
+	}
+	// Vertices no triangle uses keep their relative order at the end.
+	for (size_t v = 0; v < vertices; ++v) {
+		if (remap[v] != none)
+			continue ;
+		std::copy_n(&buffer[v * stride], stride, &moved[next * stride]);
+		++next;
+	}
+	buffer.swap(moved);
+}
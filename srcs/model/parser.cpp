@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <system_error>
+
+#include "../../headers/model/parser.hpp"
+
+// SCANNERS
+
+static inline bool is_blank(const char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool is_digit(const char c) {
+	return static_cast<unsigned char>(c - '0') < 10;
+}
+
+const char *skip_blanks(const char *p, const char *end) {
+	while (p < end && is_blank(*p))
+		++p;
+	return p;
+}
+
+const char *line_end(const char *p, const char *end) {
+	const void *nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+
+	return nl ? static_cast<const char *>(nl) : end;
+}
+
+bool scan_token(const char *&p, const char *end, const char *&token, size_t &len) {
+	const char *s = skip_blanks(p, end);
+
+	token = s;
+	while (s < end && *s != '\n' && !is_blank(*s))
+		++s;
+	len = static_cast<size_t>(s - token);
+	p = s;
+	return len > 0;
+}
+
+bool scan_int(const char *&p, const char *end, int &out) {
+	const char	*s = skip_blanks(p, end);
+	bool		neg = false;
+	int64_t		value = 0;
+
+	if (s < end && (*s == '-' || *s == '+'))
+		neg = *s++ == '-';
+	if (s >= end || !is_digit(*s))
+		return false;
+	while (s < end && is_digit(*s)) {
+		if (value < INT32_MAX)
+			value = value * 10 + (*s - '0');
+		++s;
+	}
+	if (value > INT32_MAX)
+		value = INT32_MAX;
+	out = static_cast<int>(neg ? -value : value);
+	p = s;
+	return true;
+}
+
+// Exact powers of ten: up to 1e10 in float and 1e22 in double.
+static const float	POW10_F[] = {
+	1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+static const double	POW10_D[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Slow path for the rare literals the fast paths cannot round exactly:
+// more than 19 significant digits, huge exponents or double-rounding ties.
+// from_chars ignores the locale, unlike strtof. Out of range it leaves the
+// value alone, so `large` tells an overflow from an underflow.
+static float slow_float(const char *start, const char *stop, const bool large) {
+	const bool	neg = start < stop && *start == '-';
+	float		value = 0.0f;
+
+	if (start < stop && (*start == '-' || *start == '+'))
+		++start;
+	if (std::from_chars(start, stop, value).ec == std::errc::result_out_of_range)
+		value = large ? std::numeric_limits<float>::infinity() : 0.0f;
+	return neg ? -value : value;
+}
+
+// DOC: W. D. Clinger, "How to read floating point numbers accurately" (1990)
+// A mantissa that fits the target's significand multiplied or divided by an
+// exactly representable power of ten is a single correctly rounded operation.
+bool scan_float(const char *&p, const char *end, float &out) {
+	const char	*s = skip_blanks(p, end);
+	const char	*start = s;
+	bool		neg = false, any = false, truncated = false;
+	uint64_t	mantissa = 0;
+	int			digits = 0, exp10 = 0;
+
+	if (s < end && (*s == '-' || *s == '+'))
+		neg = *s++ == '-';
+	for (; s < end && is_digit(*s); ++s) {
+		any = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+			if (mantissa)
+				++digits;
+		}
+		else {
+			++exp10;
+			truncated |= *s != '0';
+		}
+	}
+	if (s < end && *s == '.') {
+		for (++s; s < end && is_digit(*s); ++s) {
+			any = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+				if (mantissa)
+					++digits;
+				--exp10;
+			}
+			else
+				truncated |= *s != '0';
+		}
+	}
+	if (!any)
+		return false;
+	if (s < end && (*s == 'e' || *s == 'E')) {
+		const char	*e = s + 1;
+		bool		eneg = false;
+		int			evalue = 0;
+
+		if (e < end && (*e == '-' || *e == '+'))
+			eneg = *e++ == '-';
+		if (e < end && is_digit(*e)) {
+			for (; e < end && is_digit(*e); ++e)
+				if (evalue < 100000)
+					evalue = evalue * 10 + (*e - '0');
+			exp10 += eneg ? -evalue : evalue;
+			s = e;
+		}
+	}
+	p = s;
+
+	if (mantissa == 0)
+		out = neg ? -0.0f : 0.0f;
+	else if (!truncated && mantissa <= (1ull << 24) && exp10 >= -10 && exp10 <= 10) {
+		float value = static_cast<float>(mantissa);
+		value = exp10 < 0 ? value / POW10_F[-exp10] : value * POW10_F[exp10];
+		out = neg ? -value : value;
+	}
+	else if (!truncated && mantissa <= (1ull << 53) && exp10 >= -22 && exp10 <= 22) {
+		double		d = static_cast<double>(mantissa);
+		uint64_t	bits;
+
+		d = exp10 < 0 ? d / POW10_D[-exp10] : d * POW10_D[exp10];
+		std::memcpy(&bits, &d, sizeof(bits));
+		// A double sitting exactly halfway between two floats may be a
+		// rounded image of a value that is not: only then go the slow way.
+		if ((bits & 0x1fffffffull) == 0x10000000ull || d < 1.17549435e-38)
+			out = slow_float(start, s, false);
+		else
+			out = static_cast<float>(neg ? -d : d);
+	}
+	else
+		out = slow_float(start, s, digits + exp10 > 0);
+	return true;
+}
+
+// CHUNKS
+
+// bounds receives count + 1 pointers; every inner bound is moved forward to
+// the start of a line so no record straddles two chunks.
+void split_chunks(const char *begin, const char *end, std::vector<const char *> &bounds) {
+	const size_t size = static_cast<size_t>(end - begin);
+	const size_t count = std::max<size_t>(1, size / OBJ_CHUNK_MIN);
+
+	bounds.clear();
+	bounds.push_back(begin);
+	for (size_t i = 1; i < count; ++i) {
+		const char *cut = begin + size / count * i;
+
+		if (cut <= bounds.back())
+			continue ;
+		cut = line_end(cut, end);
+		if (cut < end)
+			++cut;
+		if (cut > bounds.back() && cut < end)
+			bounds.push_back(cut);
+	}
+	bounds.push_back(end);
+}
+
+static bool is_prefix(const char *token, const size_t len, const char *prefix) {
+	return std::strlen(prefix) == len && std::memcmp(token, prefix, len) == 0;
+}
+
+static void load_vertex(ObjChunk &chunk, const char *p, const char *eol) {
+	Vertex vertex{};
+
+	scan_float(p, eol, vertex.x) && scan_float(p, eol, vertex.y) && scan_float(p, eol, vertex.z);
+	vertex.texX = vertex.x;
+	vertex.texY = vertex.y;
+	chunk.vertices.push_back(vertex);
+}
+
+// Accepts v, v/vt, v//vn and v/vt/vn corners. A missing vt or vn is recorded
+// as 0, which triangleCreator treats as "none". Corners go straight into the
+// chunk's face arrays; the face is closed by pushing its end offset.
+static void load_faces(ObjChunk &chunk, const char *p, const char *eol) {
+	bool		slash = false;
+	const char	*token;
+	size_t		len;
+	FaceList	&faces = chunk.faces;
+
+	while (scan_token(p, eol, token, len)) {
+		const char	*t = token, *tend = token + len;
+		int			i = 0, j = 0, n = 0;
+
+		if (!scan_int(t, tend, i))
+			break ;
+		if (t < tend && *t == '/') {
+			slash = true;
+			++t;
+			scan_int(t, tend, j);
+			if (t < tend && *t == '/') {
+				++t;
+				scan_int(t, tend, n);
+			}
+		}
+		faces.vertices.push_back(i);
+		faces.textures.push_back(j);
+		faces.normals.push_back(n);
+	}
+	const size_t corners = faces.vertices.size() - faces.offsets.back();
+	if (corners >= 3) {
+		faces.offsets.push_back(static_cast<uint32_t>(faces.vertices.size()));
+		faces.groups.push_back(chunk.group);
+		faces.materials.push_back(chunk.material);
+		chunk.last_slash = slash;
+	}
+	else
+		throw Model::CreationError("Too many indexes: " + std::to_string(corners));
+}
+
+void parse_chunk(const char *p, const char *end, ObjChunk &chunk) {
+	while (p < end) {
+		const char	*eol = line_end(p, end);
+		const char	*prefix, *token;
+		size_t		len, token_len;
+
+		if (scan_token(p, eol, prefix, len)) {
+			if (is_prefix(prefix, len, "v")) {
+				load_vertex(chunk, p, eol);
+			}
+			else if (is_prefix(prefix, len, "vt")) {
+				UV uvVal{};
+				scan_float(p, eol, uvVal.u) && scan_float(p, eol, uvVal.v) && scan_float(p, eol, uvVal.w);
+				chunk.textures.push_back(uvVal);
+			}
+			else if (is_prefix(prefix, len, "vn")) {
+				float normalX = 0, normalY = 0, normalZ = 0;
+				scan_float(p, eol, normalX) && scan_float(p, eol, normalY) && scan_float(p, eol, normalZ);
+				chunk.normals.emplace_back(normalX, normalY, normalZ);
+			}
+			else if (is_prefix(prefix, len, "f")) {
+				chunk.faces_count++;
+				load_faces(chunk, p, eol);
+			}
+			else if (is_prefix(prefix, len, "s")) {
+				int group = SMOOTHING_OFF;
+				scan_int(p, eol, group);	// "off" leaves it at SMOOTHING_OFF
+				chunk.group = std::max(group, SMOOTHING_OFF);
+			}
+			else if (is_prefix(prefix, len, "o")) {
+				if (scan_token(p, eol, token, token_len))
+					chunk.directives.push_back({ObjDirective::NAME, std::string_view(token, token_len)});
+			}
+			else if (is_prefix(prefix, len, "usemtl")) {
+				scan_token(p, eol, token, token_len);
+				chunk.directives.push_back({ObjDirective::USEMTL, std::string_view(token, token_len)});
+				++chunk.material;
+			}
+			else if (is_prefix(prefix, len, "mtllib")) {
+				scan_token(p, eol, token, token_len);
+				chunk.directives.push_back({ObjDirective::MTLLIB, std::string_view(token, token_len)});
+			}
+		}
+		p = eol < end ? eol + 1 : end;
+	}
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../../headers/model/model.hpp"
+#include "../../headers/model/quantize.hpp"
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay tightly packed");
+
+// Round to nearest even; overflow goes to infinity and tiny values to
+// subnormals or zero, like the GPU conversion.
+uint16_t float_to_half(const float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	const uint32_t	sign = (bits >> 16) & 0x8000u;
+	const uint32_t	exponent = (bits >> 23) & 0xffu;
+	uint32_t		mantissa = bits & 0x7fffffu;
+
+	if (exponent == 0xffu)
+		return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+	const int e = static_cast<int>(exponent) - 127 + 15;
+	if (e >= 0x1f)
+		return static_cast<uint16_t>(sign | 0x7c00u);
+	if (e <= 0) {
+		if (e < -10)
+			return static_cast<uint16_t>(sign);
+		mantissa |= 0x800000u;
+		const int		shift = 14 - e;
+		const uint32_t	half = mantissa >> shift;
+		const uint32_t	rest = mantissa & ((1u << shift) - 1);
+		const uint32_t	midpoint = 1u << (shift - 1);
+		return static_cast<uint16_t>(sign | (half + (rest > midpoint || (rest == midpoint && (half & 1)))));
+	}
+	const uint32_t half = sign | (static_cast<uint32_t>(e) << 10) | (mantissa >> 13);
+	const uint32_t rest = mantissa & 0x1fffu;
+	// A carry out of the mantissa correctly bumps the exponent.
+	return static_cast<uint16_t>(half + (rest > 0x1000u || (rest == 0x1000u && (half & 1))));
+}
+
+float half_to_float(const uint16_t half) {
+	const uint32_t	sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+	const int		exponent = (half >> 10) & 0x1f;
+	const uint32_t	mantissa = half & 0x3ffu;
+	float			value;
+
+	if (exponent == 0)
+		value = std::ldexp(static_cast<float>(mantissa), -24);
+	else if (exponent == 0x1f)
+		value = mantissa ? NAN : INFINITY;
+	else
+		value = std::ldexp(static_cast<float>(mantissa | 0x400u), exponent - 25);
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	bits |= sign;
+	std::memcpy(&value, &bits, sizeof(bits));
+	return value;
+}
+
+// Signed normalized 10-bit component, decoded by GL 3.3 as (2c + 1) / 1023.
+static uint32_t snorm10(const float value) {
+	const float	clamped = std::max(-1.0f, std::min(1.0f, value));
+	const int	c = static_cast<int>(std::lround((clamped * 1023.0f - 1.0f) / 2.0f));
+
+	return static_cast<uint32_t>(std::max(-512, std::min(511, c))) & 0x3ffu;
+}
+
+static float unsnorm10(const uint32_t bits) {
+	const int c = static_cast<int>(bits << 22) >> 22;
+
+	return (2.0f * static_cast<float>(c) + 1.0f) / 1023.0f;
+}
+
+QuantizationError quantize_vertices(const std::vector<float> &buffer, const glm::vec3 min, const glm::vec3 max,
+	std::vector<PackedVertex> &out) {
+	const size_t		count = buffer.size() / VERTEX_FLOATS;
+	const glm::vec3		extent = max - min;
+	QuantizationError	error{0.0f, 0.0f, 0.0f};
+	float				min_cos = 1.0f;
+
+	out.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		const float		*v = &buffer[i * VERTEX_FLOATS];
+		PackedVertex	&packed = out[i];
+
+		for (int k = 0; k < 3; ++k) {
+			const float t = extent[k] > 0.0f ? (v[k] - min[k]) / extent[k] : 0.0f;
+			packed.position[k] = static_cast<uint16_t>(std::lround(std::max(0.0f, std::min(1.0f, t)) * 65535.0f));
+			const float back = min[k] + static_cast<float>(packed.position[k]) / 65535.0f * extent[k];
+			error.position = std::max(error.position, std::fabs(back - v[k]));
+		}
+		packed.position[3] = 0;
+
+		for (int k = 0; k < 2; ++k) {
+			packed.uv[k] = float_to_half(v[3 + k]);
+			if (std::isfinite(v[3 + k]))
+				error.uv = std::max(error.uv, std::fabs(half_to_float(packed.uv[k]) - v[3 + k]));
+		}
+
+		packed.normal = snorm10(v[5]) | snorm10(v[6]) << 10 | snorm10(v[7]) << 20;
+		const glm::vec3 normal(v[5], v[6], v[7]);
+		const glm::vec3 back(unsnorm10(packed.normal), unsnorm10(packed.normal >> 10), unsnorm10(packed.normal >> 20));
+		if (glm::length(normal) > 0.0f && glm::length(back) > 0.0f)
+			min_cos = std::min(min_cos, glm::dot(glm::normalize(normal), glm::normalize(back)));
+	}
+	error.normal = std::acos(std::max(-1.0f, std::min(1.0f, min_cos))) * 180.0f / static_cast<float>(M_PI);
+	return error;
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+#include <glm/glm.hpp>
+
+#include "../../headers/model/simplify.hpp"
+
+namespace {
+
+// Symmetric 4x4 matrix: the sum of the squared distances to a set of planes.
+struct Quadric {
+	double	xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+
+	void addPlane(const double a, const double b, const double c, const double d) {
+		xx += a * a; xy += a * b; xz += a * c; xw += a * d;
+		yy += b * b; yz += b * c; yw += b * d;
+		zz += c * c; zw += c * d;
+		ww += d * d;
+	}
+
+	Quadric &operator+=(const Quadric &q) {
+		xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw;
+		yy += q.yy; yz += q.yz; yw += q.yw;
+		zz += q.zz; zw += q.zw;
+		ww += q.ww;
+		return *this;
+	}
+
+	double error(const glm::vec3 &p) const {
+		const double x = p.x, y = p.y, z = p.z;
+
+		return xx * x * x + 2 * xy * x * y + 2 * xz * x * z + 2 * xw * x
+			+ yy * y * y + 2 * yz * y * z + 2 * yw * y
+			+ zz * z * z + 2 * zw * z
+			+ ww;
+	}
+};
+
+// Moves `from` onto `to`. The versions tell stale entries apart: any
+// collapse into a vertex changes its quadric and its neighbourhood.
+struct Collapse {
+	double		cost;
+	uint32_t	from, to;
+	uint32_t	from_version, to_version;
+
+	bool operator>(const Collapse &other) const { return cost > other.cost; }
+};
+
+}
+
+float simplify(const std::vector<uint32_t> &indices, const std::vector<float> &buffer, const size_t stride,
+	const size_t target, std::vector<uint32_t> &out) {
+	const size_t	vertices = buffer.size() / stride;
+	size_t			triangles = indices.size() / 3;
+	double			worst = 0.0;
+
+	out = indices;
+	if (triangles <= target)
+		return 0.0f;
+
+	std::vector<glm::vec3> position(vertices);
+	for (size_t v = 0; v < vertices; ++v)
+		position[v] = glm::vec3(buffer[v * stride], buffer[v * stride + 1], buffer[v * stride + 2]);
+
+	// Seams: the vertices sharing a position with another one.
+	std::vector<bool>		locked(vertices, false);
+	std::vector<uint32_t>	by_position(vertices);
+	for (size_t v = 0; v < vertices; ++v)
+		by_position[v] = static_cast<uint32_t>(v);
+	auto less = [&position](const uint32_t a, const uint32_t b) {
+		const glm::vec3 &p = position[a], &q = position[b];
+		return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+	};
+	std::sort(by_position.begin(), by_position.end(), less);
+	for (size_t i = 1; i < vertices; ++i)
+		if (!less(by_position[i - 1], by_position[i]))
+			locked[by_position[i]] = locked[by_position[i - 1]] = true;
+
+	// Borders and non-manifold edges: those without exactly two triangles.
+	std::vector<uint64_t> edges;
+	edges.reserve(indices.size());
+	for (size_t t = 0; t < triangles; ++t)
+		for (int c = 0; c < 3; ++c) {
+			const uint32_t a = indices[t * 3 + c], b = indices[t * 3 + (c + 1) % 3];
+			edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+		}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0, j; i < edges.size(); i = j) {
+		for (j = i + 1; j < edges.size() && edges[j] == edges[i]; ++j)
+			;
+		if (j - i != 2)
+			locked[edges[i] >> 32] = locked[edges[i] & 0xffffffffu] = true;
+	}
+	edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+	std::vector<Quadric>				quadric(vertices);
+	std::vector<std::vector<uint32_t>>	around(vertices);	// triangles, possibly dead
+	std::vector<bool>					dead(triangles, false);
+	for (size_t t = 0; t < triangles; ++t) {
+		const uint32_t	*tri = &out[t * 3];
+		glm::vec3		n = glm::cross(position[tri[1]] - position[tri[0]], position[tri[2]] - position[tri[0]]);
+		const float		length = glm::length(n);
+
+		for (int c = 0; c < 3; ++c)
+			around[tri[c]].push_back(static_cast<uint32_t>(t));
+		if (length == 0.0f)
+			continue ;
+		n /= length;
+		const float d = -glm::dot(n, position[tri[0]]);
+		for (int c = 0; c < 3; ++c)
+			quadric[tri[c]].addPlane(n.x, n.y, n.z, d);
+	}
+
+	std::vector<uint32_t>	version(vertices, 0);
+	std::vector<bool>		removed(vertices, false);
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+	auto push = [&](const uint32_t a, const uint32_t b) {
+		Quadric q = quadric[a];
+		q += quadric[b];
+		const double to_b = locked[a] ? INFINITY : q.error(position[b]);
+		const double to_a = locked[b] ? INFINITY : q.error(position[a]);
+		if (to_b <= to_a && to_b != INFINITY)
+			heap.push({to_b, a, b, version[a], version[b]});
+		else if (to_a != INFINITY)
+			heap.push({to_a, b, a, version[b], version[a]});
+	};
+	for (const uint64_t edge : edges)
+		push(static_cast<uint32_t>(edge >> 32), static_cast<uint32_t>(edge));
+
+	// A collapse is refused when it turns a surviving triangle around.
+	auto flips = [&](const uint32_t from, const uint32_t to) {
+		for (const uint32_t t : around[from]) {
+			const uint32_t *tri = &out[t * 3];
+			if (dead[t] || tri[0] == to || tri[1] == to || tri[2] == to)
+				continue ;
+			glm::vec3 p[3] = {position[tri[0]], position[tri[1]], position[tri[2]]};
+			const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			for (int c = 0; c < 3; ++c)
+				if (tri[c] == from)
+					p[c] = position[to];
+			const glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+			if (glm::dot(before, after) <= 0.0f)
+				return true;
+		}
+		return false;
+	};
+
+	while (triangles > target && !heap.empty()) {
+		const Collapse collapse = heap.top();
+		const uint32_t from = collapse.from, to = collapse.to;
+		heap.pop();
+
+		if (removed[from] || removed[to] || version[from] != collapse.from_version
+			|| version[to] != collapse.to_version || flips(from, to))
+			continue ;
+
+		for (const uint32_t t : around[from]) {
+			uint32_t *tri = &out[t * 3];
+			if (dead[t])
+				continue ;
+			if (tri[0] == to || tri[1] == to || tri[2] == to) {
+				dead[t] = true;
+				--triangles;
+				continue ;
+			}
+			for (int c = 0; c < 3; ++c)
+				if (tri[c] == from)
+					tri[c] = to;
+			around[to].push_back(t);
+		}
+		std::vector<uint32_t>().swap(around[from]);
+		quadric[to] += quadric[from];
+		removed[from] = true;
+		++version[to];
+		worst = std::max(worst, collapse.cost);
+
+		// New candidates around `to`, dropping the dead triangles on the way.
+		std::vector<uint32_t> &list = around[to];
+		list.erase(std::remove_if(list.begin(), list.end(), [&dead](const uint32_t t) { return dead[t]; }), list.end());
+		for (const uint32_t t : list)
+			for (int c = 0; c < 3; ++c)
+				if (out[t * 3 + c] != to)
+					push(to, out[t * 3 + c]);
+	}
+
+	size_t kept = 0;
+	for (size_t t = 0; t < dead.size(); ++t)
+		if (!dead[t]) {
+			for (int c = 0; c < 3; ++c)
+				out[kept * 3 + c] = out[t * 3 + c];
+			++kept;
+		}
+	out.resize(kept * 3);
+	return static_cast<float>(std::sqrt(std::max(worst, 0.0)));
+}
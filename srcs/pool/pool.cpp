@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <memory>
+
+#include "../../headers/pool/pool.hpp"
+
+// `threads` is the total concurrency, the thread calling parallelFor included.
+ThreadPool::ThreadPool(unsigned int threads) {
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+	for (unsigned int i = 1; i < threads; ++i)
+		workers.emplace_back(&ThreadPool::run, this);
+
+	if constexpr (DEBUG) {
+		std::cout << "Thread pool created (" << threads << " threads)" << std::endl;
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeup.notify_all();
+	for (auto &worker : workers)
+		worker.join();
+}
+
+ThreadPool &ThreadPool::shared() {
+	static ThreadPool pool;
+
+	return pool;
+}
+
+unsigned int ThreadPool::size() const {
+	return static_cast<unsigned int>(workers.size()) + 1;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+	if (workers.empty()) {
+		task();
+		return ;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	wakeup.notify_one();
+}
+
+void ThreadPool::run() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeup.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty())
+				return ;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+// Indices are handed out through an atomic counter. Helpers that start after
+// everything has been claimed return immediately, so the caller only ever
+// waits for work that is actually running.
+void ThreadPool::parallelFor(const size_t count, const std::function<void(size_t)> &fn) {
+	struct Shared {
+		std::atomic<size_t>		next{0};
+		size_t					done = 0;
+		std::exception_ptr		error;
+		std::mutex				mutex;
+		std::condition_variable	finished;
+	};
+
+	if (count == 0)
+		return ;
+	auto state = std::make_shared<Shared>();
+	auto work = [state, count, &fn]() {
+		size_t i, ran = 0;
+		std::exception_ptr error;
+
+		while ((i = state->next.fetch_add(1)) < count) {
+			try {
+				fn(i);
+			}
+			catch (...) {
+				if (!error)
+					error = std::current_exception();
+			}
+			++ran;
+		}
+		if (ran) {
+			std::lock_guard<std::mutex> lock(state->mutex);
+			if (error && !state->error)
+				state->error = error;
+			state->done += ran;
+			if (state->done == count)
+				state->finished.notify_all();
+		}
+	};
+
+	const size_t helpers = std::min(count, workers.size() + 1) - 1;
+	for (size_t h = 0; h < helpers; ++h)
+		submit(work);
+	work();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state, count] { return state->done == count; });
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "../../headers/shaders/materials.hpp"
+#include "../../headers/textures/decoder.hpp"
+
+static_assert(sizeof(GpuMaterial) == 64, "GpuMaterial must match the std140 layout of fragment.gls");
+
+// Bilinear resampling of an RGBA image, pixel centres aligned.
+static void resize_rgba(const unsigned char *src, const int width, const int height,
+	const int target_width, const int target_height, unsigned char *dst) {
+	const float sx = static_cast<float>(width) / static_cast<float>(target_width);
+	const float sy = static_cast<float>(height) / static_cast<float>(target_height);
+
+	for (int y = 0; y < target_height; ++y) {
+		const float	fy = std::clamp((static_cast<float>(y) + 0.5f) * sy - 0.5f, 0.0f, static_cast<float>(height - 1));
+		const int	y0 = static_cast<int>(fy), y1 = std::min(y0 + 1, height - 1);
+		const float	wy = fy - static_cast<float>(y0);
+
+		for (int x = 0; x < target_width; ++x) {
+			const float	fx = std::clamp((static_cast<float>(x) + 0.5f) * sx - 0.5f, 0.0f, static_cast<float>(width - 1));
+			const int	x0 = static_cast<int>(fx), x1 = std::min(x0 + 1, width - 1);
+			const float	wx = fx - static_cast<float>(x0);
+
+			for (int c = 0; c < 4; ++c) {
+				const float top = src[(y0 * width + x0) * 4 + c] * (1.0f - wx) + src[(y0 * width + x1) * 4 + c] * wx;
+				const float bottom = src[(y1 * width + x0) * 4 + c] * (1.0f - wx) + src[(y1 * width + x1) * 4 + c] * wx;
+				dst[(y * target_width + x) * 4 + c] = static_cast<unsigned char>(top * (1.0f - wy) + bottom * wy + 0.5f);
+			}
+		}
+	}
+}
+
+MaterialBatch::MaterialBatch() {
+	glGenBuffers(1, &ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferData(GL_UNIFORM_BUFFER, MATERIAL_BATCH_MAX * sizeof(GpuMaterial), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+MaterialBatch::~MaterialBatch() {
+	glDeleteBuffers(1, &ubo);
+	glDeleteTextures(1, &maps);
+}
+
+// A map used by several materials is one layer. Maps that fail to load
+// leave their materials untextured.
+GLsizei MaterialBatch::loadMaps(const Model &model, std::vector<GpuMaterial> &materials) {
+	std::map<std::string, int>	layers;
+	std::vector<DecodedPixels>	images;
+	int							width = 0, height = 0;
+
+	for (size_t i = 0; i < materials.size(); ++i) {
+		const std::string &path = model.getMaterial(i).diffuse_map;
+		if (path.empty())
+			continue ;
+		auto found = layers.find(path);
+		if (found == layers.end()) {
+			DecodedPixels image;
+			const bool decoded = decode_image(path, default_image_decoder(), 4, image);
+			if (!decoded)
+				std::cerr << "Texture " << path << " could not be loaded." << std::endl;
+			else {
+				width = std::max(width, std::min(image.width, MATERIAL_MAP_MAX_SIZE));
+				height = std::max(height, std::min(image.height, MATERIAL_MAP_MAX_SIZE));
+				images.push_back(std::move(image));
+			}
+			found = layers.emplace(path, decoded ? static_cast<int>(images.size() - 1) : -1).first;
+		}
+		materials[i].map = static_cast<float>(found->second);
+	}
+	if (images.empty())
+		return 0;
+
+	std::vector<unsigned char> resized(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+	glGenTextures(1, &maps);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, maps);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, static_cast<GLsizei>(images.size()), 0,
+				 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	for (size_t layer = 0; layer < images.size(); ++layer) {
+		DecodedPixels &image = images[layer];
+		const unsigned char *pixels = image.data.get();
+		if (image.width != width || image.height != height) {
+			resize_rgba(image.data.get(), image.width, image.height, width, height, resized.data());
+			pixels = resized.data();
+		}
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), width, height, 1,
+						GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		image.data.reset();
+	}
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return static_cast<GLsizei>(images.size());
+}
+
+bool MaterialBatch::build(const Model &model, const GLuint program) {
+	if (model.getMaterialCount() > MATERIAL_BATCH_MAX) {
+		std::cerr << "Too many materials to draw at once (" << model.getMaterialCount() << ", at most "
+			<< MATERIAL_BATCH_MAX << "), drawing them one by one." << std::endl;
+		return false;
+	}
+
+	std::vector<GpuMaterial> materials(model.getMaterialCount());
+	for (size_t i = 0; i < materials.size(); ++i) {
+		const Mtl &mtl = model.getMaterial(i).mtl;
+		materials[i] = {{mtl.ka.r, mtl.ka.g, mtl.ka.b, 0.0f}, {mtl.kd.r, mtl.kd.g, mtl.kd.b, 0.0f},
+			{mtl.ks.r, mtl.ks.g, mtl.ks.b, 0.0f}, mtl.d, mtl.ns, static_cast<float>(mtl.illum), -1.0f};
+	}
+	const GLsizei layers = loadMaps(model, materials);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, materials.size() * sizeof(GpuMaterial), materials.data()); // NOLINT(*-narrowing-conversions)
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Materials"), MATERIAL_UBO_BINDING);
+	ready = true;
+
+	if constexpr (DEBUG) {
+		std::cout << "Material batch: " << model.getMaterialCount() << " materials, " << layers << " maps" << std::endl;
+	}
+	return true;
+}
+
+void MaterialBatch::bind() const {
+	glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_UBO_BINDING, ubo);
+	glActiveTexture(GL_TEXTURE0 + MATERIAL_MAP_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, maps);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+bool MaterialBatch::isReady() const {
+	return ready;
+}
@@ -132,16 +132,27 @@ void Shader::loadMTLToFragment(Shader &self, const Model &model) {
 	}
 
 	glUseProgram(self.program_id);
-	glUniform3f(self.ka, mtl.ka.r, mtl.ka.g, mtl.ka.b);
-	glUniform3f(self.kd, mtl.kd.r, mtl.kd.g, mtl.kd.b);
-	glUniform3f(self.ks, mtl.ks.r, mtl.ks.g, mtl.ks.b);
-	glUniform1f(self.tr, mtl.tr);
-	glUniform1f(self.d, mtl.d);
-	glUniform1f(self.ns, mtl.ns);
-	glUniform1i(self.illum, mtl.illum);
+	self.useMaterial(mtl);
 	glUniform3f(self.light_pos, model.light_source.x, model.light_source.y, model.light_source.z);
 }
 
+// The material is only known once the model has finished loading.
+void Shader::setMaterial(const Model &model) {
+	loadMTLToFragment(*this, model);
+}
+
+// Expects the program to be in use; drawing switches materials between
+// submeshes.
+void Shader::useMaterial(const Mtl &mtl) {
+	glUniform3f(ka, mtl.ka.r, mtl.ka.g, mtl.ka.b);
+	glUniform3f(kd, mtl.kd.r, mtl.kd.g, mtl.kd.b);
+	glUniform3f(ks, mtl.ks.r, mtl.ks.g, mtl.ks.b);
+	glUniform1f(tr, mtl.tr);
+	glUniform1f(d, mtl.d);
+	glUniform1f(ns, mtl.ns);
+	glUniform1i(illum, mtl.illum);
+}
+
 unsigned int Shader::getId() const {
 	return program_id;
 }
\ No newline at end of file
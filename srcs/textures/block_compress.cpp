@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "../../headers/textures/block_compress.hpp"
+#include "../../headers/pool/pool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define BLOCK_SSE 1
+#else
+# define BLOCK_SSE 0
+#endif
+
+#define BLOCK_INSET_SHIFT	4		// endpoints move in by 1/16 of the range
+
+TextureFormat block_format(const int channels, const bool s3tc) {
+	if (channels == 2)
+		return TEXTURE_BC5;
+	if (channels == 3 && s3tc)
+		return TEXTURE_BC1;
+	if (channels == 4 && s3tc)
+		return TEXTURE_BC3;
+	return TEXTURE_RAW;
+}
+
+// 4x4 pixels from (x, y) as RGBA, the edge pixels repeated past the image;
+// missing channels are 0, a missing alpha 255.
+static void load_block(const unsigned char *pixels, const int width, const int height, const int channels,
+	const int x, const int y, unsigned char block[64]) {
+	for (int j = 0; j < 4; ++j) {
+		const unsigned char *row = pixels + static_cast<size_t>(std::min(y + j, height - 1)) * width * channels;
+		for (int i = 0; i < 4; ++i) {
+			const unsigned char	*src = row + static_cast<size_t>(std::min(x + i, width - 1)) * channels;
+			unsigned char		*dst = block + (j * 4 + i) * 4;
+			for (int c = 0; c < 4; ++c)
+				dst[c] = c < channels ? src[c] : c == 3 ? 255 : 0;
+		}
+	}
+}
+
+// Per channel minimum and maximum of the 16 pixels.
+static void block_bounds(const unsigned char block[64], unsigned char low[4], unsigned char high[4]) {
+#if BLOCK_SSE
+	const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+	const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16));
+	const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 32));
+	const __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 48));
+	__m128i mn = _mm_min_epu8(_mm_min_epu8(r0, r1), _mm_min_epu8(r2, r3));
+	__m128i mx = _mm_max_epu8(_mm_max_epu8(r0, r1), _mm_max_epu8(r2, r3));
+	mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+	mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(1, 0, 3, 2)));
+	mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+	mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(2, 3, 0, 1)));
+	const uint32_t lo = static_cast<uint32_t>(_mm_cvtsi128_si32(mn));
+	const uint32_t hi = static_cast<uint32_t>(_mm_cvtsi128_si32(mx));
+	std::memcpy(low, &lo, 4);
+	std::memcpy(high, &hi, 4);
+#else
+	for (int c = 0; c < 4; ++c) {
+		low[c] = high[c] = block[c];
+		for (int i = 1; i < 16; ++i) {
+			low[c] = std::min(low[c], block[i * 4 + c]);
+			high[c] = std::max(high[c], block[i * 4 + c]);
+		}
+	}
+#endif
+}
+
+static uint16_t to_565(const int r, const int g, const int b) {
+	return static_cast<uint16_t>((r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+}
+
+static void from_565(const uint16_t c, int rgb[3]) {
+	const int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+
+	rgb[0] = r << 3 | r >> 2;
+	rgb[1] = g << 2 | g >> 4;
+	rgb[2] = b << 3 | b >> 2;
+}
+
+static void put16(unsigned char *out, const uint16_t v) {
+	out[0] = static_cast<unsigned char>(v);
+	out[1] = static_cast<unsigned char>(v >> 8);
+}
+
+// BC1 colours. The bounding box diagonal is flipped on red and blue when
+// they decrease as green increases, so it follows the colours of the block.
+static void encode_color(const unsigned char block[64], unsigned char out[8]) {
+	unsigned char	low[4], high[4];
+	int				center[3], covariance[2] = {0, 0};
+
+	block_bounds(block, low, high);
+	for (int c = 0; c < 3; ++c)
+		center[c] = (low[c] + high[c] + 1) / 2;
+	for (int i = 0; i < 16; ++i) {
+		const int g = block[i * 4 + 1] - center[1];
+		covariance[0] += (block[i * 4] - center[0]) * g;
+		covariance[1] += (block[i * 4 + 2] - center[2]) * g;
+	}
+
+	int max[3], min[3];
+	for (int c = 0; c < 3; ++c) {
+		const int inset = (high[c] - low[c]) >> BLOCK_INSET_SHIFT;
+		max[c] = high[c] - inset;
+		min[c] = low[c] + inset;
+	}
+	if (covariance[0] < 0)
+		std::swap(max[0], min[0]);
+	if (covariance[1] < 0)
+		std::swap(max[2], min[2]);
+
+	uint16_t c0 = to_565(max[0], max[1], max[2]), c1 = to_565(min[0], min[1], min[2]);
+	if (c0 < c1)
+		std::swap(c0, c1);
+	put16(out, c0);
+	put16(out + 2, c1);
+	std::memset(out + 4, 0, 4);
+	if (c0 == c1)
+		return ;
+
+	int palette[4][3];
+	from_565(c0, palette[0]);
+	from_565(c1, palette[1]);
+	for (int c = 0; c < 3; ++c) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+	uint32_t indices = 0;
+	for (int i = 0; i < 16; ++i) {
+		int best = 0, best_distance = INT32_MAX;
+		for (int p = 0; p < 4; ++p) {
+			int distance = 0;
+			for (int c = 0; c < 3; ++c)
+				distance += (block[i * 4 + c] - palette[p][c]) * (block[i * 4 + c] - palette[p][c]);
+			if (distance < best_distance) {
+				best_distance = distance;
+				best = p;
+			}
+		}
+		indices |= static_cast<uint32_t>(best) << (2 * i);
+	}
+	for (int b = 0; b < 4; ++b)
+		out[4 + b] = static_cast<unsigned char>(indices >> (8 * b));
+}
+
+// BC4, the alpha block of BC3 and each half of BC5: channel `c` of the
+// block between its extremes, in the eight-value mode.
+static void encode_channel(const unsigned char block[64], const int c, unsigned char out[8]) {
+	int high = block[c], low = block[c];
+
+	for (int i = 1; i < 16; ++i) {
+		high = std::max(high, static_cast<int>(block[i * 4 + c]));
+		low = std::min(low, static_cast<int>(block[i * 4 + c]));
+	}
+	out[0] = static_cast<unsigned char>(high);
+	out[1] = static_cast<unsigned char>(low);
+	std::memset(out + 2, 0, 6);
+	if (high == low)
+		return ;
+
+	int palette[8] = {high, low};
+	for (int i = 1; i < 7; ++i)
+		palette[i + 1] = ((7 - i) * high + i * low) / 7;
+	uint64_t indices = 0;
+	for (int i = 0; i < 16; ++i) {
+		int best = 0, best_distance = INT32_MAX;
+		for (int p = 0; p < 8; ++p) {
+			const int distance = std::abs(block[i * 4 + c] - palette[p]);
+			if (distance < best_distance) {
+				best_distance = distance;
+				best = p;
+			}
+		}
+		indices |= static_cast<uint64_t>(best) << (3 * i);
+	}
+	for (int b = 0; b < 6; ++b)
+		out[2 + b] = static_cast<unsigned char>(indices >> (8 * b));
+}
+
+static void encode_block(const unsigned char block[64], const TextureFormat format, unsigned char *out) {
+	switch (format) {
+		case TEXTURE_BC1:
+			encode_color(block, out);
+			break ;
+		case TEXTURE_BC3:
+			encode_channel(block, 3, out);
+			encode_color(block, out + 8);
+			break ;
+		default:
+			encode_channel(block, 0, out);
+			encode_channel(block, 1, out + 8);
+			break ;
+	}
+}
+
+void compress_mip_chain(const TexturePixels &raw, const TextureFormat format, TexturePixels &out,
+	const std::function<void(size_t level)> &done) {
+	const size_t	block_size = format == TEXTURE_BC1 ? 8 : 16;
+	size_t			offset = 0;
+
+	out.format = format;
+	out.channels = raw.channels;
+	out.levels.clear();
+	for (const MipLevel &level : raw.levels) {
+		out.levels.push_back({offset, level.width, level.height});
+		offset += (texture_level_size(format, raw.channels, level.width, level.height) + 15) & ~static_cast<size_t>(15);
+	}
+	out.owned.reset(new unsigned char[offset]());
+	out.mapping.reset();
+	out.data = out.owned.get();
+	out.size = offset;
+
+	for (size_t l = raw.levels.size(); l-- > 0;) {
+		const MipLevel	&level = raw.levels[l];
+		const int		width = static_cast<int>(level.width), height = static_cast<int>(level.height);
+		const int		blocks_x = (width + 3) / 4;
+		unsigned char	*dst = out.owned.get() + out.levels[l].offset;
+
+		ThreadPool::shared().parallelFor(static_cast<size_t>((height + 3) / 4), [&](const size_t by) {
+			unsigned char block[64];
+			for (int bx = 0; bx < blocks_x; ++bx) {
+				load_block(raw.data + level.offset, width, height, raw.channels, bx * 4, static_cast<int>(by) * 4, block);
+				encode_block(block, format, dst + (by * static_cast<size_t>(blocks_x) + static_cast<size_t>(bx)) * block_size);
+			}
+		});
+		if (done)
+			done(l);
+	}
+}
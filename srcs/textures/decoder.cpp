@@ -0,0 +1,151 @@
+#include <climits>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "../../headers/textures/decoder.hpp"
+#include "../../headers/files/files.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../headers/stb_image.h"
+
+#ifdef SCOP_LIBJPEG
+# include <jpeglib.h>
+#endif
+
+bool image_decoder_available(const ImageDecoder decoder) {
+#ifdef SCOP_LIBJPEG
+	return decoder == DECODER_STB || decoder == DECODER_LIBJPEG;
+#else
+	return decoder == DECODER_STB;
+#endif
+}
+
+ImageDecoder default_image_decoder() {
+	return image_decoder_available(DECODER_LIBJPEG) ? DECODER_LIBJPEG : DECODER_STB;
+}
+
+const char *image_decoder_name(const ImageDecoder decoder) {
+	return decoder == DECODER_LIBJPEG ? "libjpeg" : "stb_image";
+}
+
+static bool decode_stb(const MappedFile &file, const int channels, DecodedPixels &out) {
+	int width, height, file_channels;
+
+	if (file.size() > INT_MAX)
+		return false;
+	unsigned char *pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(file.begin()),
+		static_cast<int>(file.size()), &width, &height, &file_channels, channels);
+	if (!pixels)
+		return false;
+	out.width = width;
+	out.height = height;
+	out.channels = channels ? channels : file_channels;
+	out.data = PixelData(pixels, stbi_image_free);
+	return true;
+}
+
+#ifdef SCOP_LIBJPEG
+
+// libjpeg reports errors by calling error_exit, which must not return:
+// it jumps back to decode_jpeg instead of the default exit(). `pixels` is
+// set after setjmp and read after the jump, so it must be volatile, or
+// its value there is indeterminate.
+struct JpegError {
+	jpeg_error_mgr			manager;		// first, so the library's pointer is ours
+	jmp_buf					jump;
+	unsigned char *volatile	pixels;			// freed when decoding stops halfway
+};
+
+static void jpeg_fail(j_common_ptr info) {
+	if constexpr (DEBUG) {
+		char message[JMSG_LENGTH_MAX];
+		(*info->err->format_message)(info, message);
+		std::cerr << "libjpeg: " << message << std::endl;
+	}
+	longjmp(reinterpret_cast<JpegError *>(info->err)->jump, 1);
+}
+
+static void jpeg_warning(j_common_ptr) {}
+
+// Output colour space for `channels`, false for what stb_image handles
+// instead: two channels, and four without the libjpeg-turbo extensions.
+static bool jpeg_color_space(const jpeg_decompress_struct &info, const int channels, J_COLOR_SPACE &space) {
+	switch (channels) {
+		case 0: space = info.jpeg_color_space == JCS_GRAYSCALE ? JCS_GRAYSCALE : JCS_RGB; return true;
+		case 1: space = JCS_GRAYSCALE; return true;
+		case 3: space = JCS_RGB; return true;
+#ifdef JCS_EXTENSIONS
+		case 4: space = JCS_EXT_RGBA; return true;
+#endif
+		default: return false;
+	}
+}
+
+// No object with a destructor may live in this frame: longjmp skips them.
+static bool decode_jpeg(const MappedFile &file, const int channels, DecodedPixels &out) {
+	jpeg_decompress_struct	info{};
+	JpegError				error{};
+	J_COLOR_SPACE			space;
+
+	info.err = jpeg_std_error(&error.manager);
+	error.manager.error_exit = jpeg_fail;
+	error.manager.output_message = jpeg_warning;
+	if (setjmp(error.jump)) {
+		jpeg_destroy_decompress(&info);
+		std::free(error.pixels);
+		return false;
+	}
+	jpeg_create_decompress(&info);
+	jpeg_mem_src(&info, reinterpret_cast<const unsigned char *>(file.begin()), static_cast<unsigned long>(file.size()));
+	jpeg_read_header(&info, TRUE);
+	if (info.jpeg_color_space == JCS_CMYK || info.jpeg_color_space == JCS_YCCK
+		|| !jpeg_color_space(info, channels, space)) {
+		jpeg_destroy_decompress(&info);
+		return false;
+	}
+	info.out_color_space = space;
+	jpeg_start_decompress(&info);
+
+	const size_t row = static_cast<size_t>(info.output_width) * static_cast<size_t>(info.output_components);
+	error.pixels = static_cast<unsigned char *>(std::malloc(row * info.output_height));
+	if (!error.pixels) {
+		jpeg_destroy_decompress(&info);
+		return false;
+	}
+	while (info.output_scanline < info.output_height) {
+		JSAMPROW line = error.pixels + info.output_scanline * row;
+		jpeg_read_scanlines(&info, &line, 1);
+	}
+	jpeg_finish_decompress(&info);
+
+	out.width = static_cast<int>(info.output_width);
+	out.height = static_cast<int>(info.output_height);
+	out.channels = info.output_components;
+	out.data = PixelData(error.pixels, std::free);
+	jpeg_destroy_decompress(&info);
+	return true;
+}
+
+static bool is_jpeg(const MappedFile &file) {
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(file.begin());
+	return file.size() > 3 && bytes[0] == 0xFF && bytes[1] == 0xD8 && bytes[2] == 0xFF;
+}
+
+#endif
+
+bool decode_image(const std::string &path, const ImageDecoder decoder, const int channels, DecodedPixels &out) {
+	const MappedFile file(path);
+
+	if (!file.isOpen() || file.size() == 0)
+		return false;
+#ifdef SCOP_LIBJPEG
+	// A layout libjpeg does not produce goes on to stb_image.
+	if (decoder == DECODER_LIBJPEG && is_jpeg(file) && decode_jpeg(file, channels, out))
+		return true;
+#else
+	(void)decoder;
+#endif
+	return decode_stb(file, channels, out);
+}
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../../headers/textures/mipmap.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define MIPMAP_SSE 1
+#else
+# define MIPMAP_SSE 0
+#endif
+
+// Sum of two rows, as 16-bit lanes so four bytes add up without overflow.
+static void add_rows(const unsigned char *a, const unsigned char *b, const size_t count, uint16_t *sum) {
+	size_t i = 0;
+
+#if MIPMAP_SSE
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(sum + i),
+			_mm_add_epi16(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(y, zero)));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(sum + i + 8),
+			_mm_add_epi16(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(y, zero)));
+	}
+#endif
+	for (; i < count; ++i)
+		sum[i] = static_cast<uint16_t>(a[i] + b[i]);
+}
+
+// Adds horizontal pairs of pixels of a summed row and divides by four.
+// The channel count is a template parameter so the scalar loop unrolls.
+template <int CHANNELS>
+static int reduce_pairs(const uint16_t *sum, const int first, const int pairs, unsigned char *dst) {
+	for (int x = first; x < pairs; ++x)
+		for (int c = 0; c < CHANNELS; ++c)
+			dst[x * CHANNELS + c] = static_cast<unsigned char>((sum[2 * x * CHANNELS + c]
+				+ sum[(2 * x + 1) * CHANNELS + c] + 2) >> 2);
+	return pairs;
+}
+
+// With four channels a pixel is 64 bits of the register: two unpacks split
+// four pixels into their even and odd ones.
+static void reduce_row(const uint16_t *sum, const int width, const int channels, unsigned char *dst) {
+	const int	pairs = width / 2;
+	int			x = 0;
+
+#if MIPMAP_SSE
+	if (channels == 4) {
+		const __m128i two = _mm_set1_epi16(2);
+		for (; x + 2 <= pairs; x += 2) {
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sum + x * 8));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sum + x * 8 + 8));
+			const __m128i total = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b)), two);
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x * 4),
+				_mm_packus_epi16(_mm_srli_epi16(total, 2), _mm_setzero_si128()));
+		}
+	}
+#endif
+	switch (channels) {
+		case 1: x = reduce_pairs<1>(sum, x, pairs, dst); break ;
+		case 2: x = reduce_pairs<2>(sum, x, pairs, dst); break ;
+		case 3: x = reduce_pairs<3>(sum, x, pairs, dst); break ;
+		default: x = reduce_pairs<4>(sum, x, pairs, dst); break ;
+	}
+	if (width == 1)
+		for (int c = 0; c < channels; ++c)
+			dst[c] = static_cast<unsigned char>((sum[c] * 2 + 2) >> 2);
+}
+
+void downsample_box(const unsigned char *src, const int width, const int height, const int channels,
+	unsigned char *dst) {
+	const size_t			row = static_cast<size_t>(width) * static_cast<size_t>(channels);
+	const size_t			dst_row = static_cast<size_t>(std::max(1, width / 2)) * static_cast<size_t>(channels);
+	std::vector<uint16_t>	sum(row);
+
+	for (int y = 0; y < std::max(1, height / 2); ++y) {
+		const unsigned char *top = src + static_cast<size_t>(2 * y) * row;
+		const unsigned char *bottom = src + static_cast<size_t>(std::min(2 * y + 1, height - 1)) * row;
+
+		add_rows(top, bottom, row, sum.data());
+		reduce_row(sum.data(), width, channels, dst + static_cast<size_t>(y) * dst_row);
+	}
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "../../headers/textures/texture_cache.hpp"
+#include "../../headers/textures/mipmap.hpp"
+
+// .scoptex layout:
+//
+//	ScopTexHeader
+//	levels			(16-byte aligned each, level 0 first, in the TextureFormat
+//					 of the header)
+//
+// Written in native byte order and rejected by any build whose layout
+// differs; bump SCOPTEX_VERSION whenever the content changes.
+
+#define SCOPTEX_EXTENSION		".scoptex"
+#define SCOPTEX_BC_EXTENSION	".bc.scoptex"
+#define SCOPTEX_VERSION			2u
+#define SCOPTEX_BYTE_ORDER	0x01020304u
+
+struct ScopTexHeader {
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	byte_order;
+	uint64_t	header_size;
+
+	uint64_t	source_size;
+	int64_t		source_mtime;
+	uint64_t	source_hash;
+
+	uint32_t	format;
+	uint32_t	channels;
+	uint32_t	level_count;
+	uint32_t	reserved;
+	uint64_t	data_offset, data_size;
+	MipLevel	levels[TEXTURE_MAX_LEVELS];
+};
+
+static const char	SCOPTEX_MAGIC[8] = {'S', 'C', 'O', 'P', 'T', 'E', 'X', '\0'};
+
+static size_t align16(const size_t n) {
+	return (n + 15) & ~static_cast<size_t>(15);
+}
+
+size_t texture_level_size(const TextureFormat format, const int channels, const uint32_t width, const uint32_t height) {
+	const size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+
+	switch (format) {
+		case TEXTURE_BC1: return blocks * 8;
+		case TEXTURE_BC3:
+		case TEXTURE_BC5: return blocks * 16;
+		default: return static_cast<size_t>(width) * height * static_cast<size_t>(channels);
+	}
+}
+
+size_t TexturePixels::levelSize(const size_t level) const {
+	return texture_level_size(format, channels, levels[level].width, levels[level].height);
+}
+
+void build_mip_chain(const unsigned char *pixels, const int width, const int height, const int channels,
+	TexturePixels &out) {
+	uint32_t	w = static_cast<uint32_t>(width), h = static_cast<uint32_t>(height);
+	size_t		offset = 0;
+
+	out.format = TEXTURE_RAW;
+	out.channels = channels;
+	out.levels.clear();
+	while (out.levels.size() < TEXTURE_MAX_LEVELS) {
+		out.levels.push_back({offset, w, h});
+		offset += align16(static_cast<size_t>(w) * h * static_cast<size_t>(channels));
+		if (w == 1 && h == 1)
+			break ;
+		w = std::max(1u, w / 2);
+		h = std::max(1u, h / 2);
+	}
+
+	out.owned.reset(new unsigned char[offset]);
+	out.mapping.reset();
+	out.data = out.owned.get();
+	out.size = offset;
+	std::memcpy(out.owned.get(), pixels, out.levelSize(0));
+	for (size_t i = 1; i < out.levels.size(); ++i) {
+		const MipLevel &src = out.levels[i - 1];
+		downsample_box(out.owned.get() + src.offset, static_cast<int>(src.width), static_cast<int>(src.height),
+			channels, out.owned.get() + out.levels[i].offset);
+	}
+}
+
+static std::string cache_path(const std::string &image_path, const bool compressed) {
+	return image_path + (compressed ? SCOPTEX_BC_EXTENSION : SCOPTEX_EXTENSION);
+}
+
+bool load_texture_cache(const std::string &image_path, const bool compressed, TexturePixels &out) {
+	const FileStamp source = stamp_file(image_path);
+	if (!source.exists)
+		return false;
+
+	auto mapping = std::make_shared<const MappedFile>(cache_path(image_path, compressed));
+	if (!mapping->isOpen() || mapping->size() < sizeof(ScopTexHeader))
+		return false;
+
+	ScopTexHeader header{};
+	std::memcpy(&header, mapping->begin(), sizeof(header));
+	if (std::memcmp(header.magic, SCOPTEX_MAGIC, sizeof(SCOPTEX_MAGIC)) != 0
+		|| header.version != SCOPTEX_VERSION
+		|| header.byte_order != SCOPTEX_BYTE_ORDER
+		|| header.header_size != sizeof(ScopTexHeader)
+		|| header.format > TEXTURE_BC5
+		|| header.channels < 1 || header.channels > 4
+		|| header.level_count == 0 || header.level_count > TEXTURE_MAX_LEVELS
+		|| header.data_offset % 16 != 0 || header.data_offset > mapping->size()
+		|| header.data_size > mapping->size() - header.data_offset)
+		return false;
+	for (uint32_t i = 0; i < header.level_count; ++i) {
+		const MipLevel &level = header.levels[i];
+		const uint64_t bytes = texture_level_size(static_cast<TextureFormat>(header.format),
+			static_cast<int>(header.channels), level.width, level.height);
+		if (level.width == 0 || level.height == 0 || level.offset % 16 != 0
+			|| level.offset > header.data_size || bytes > header.data_size - level.offset)
+			return false;
+	}
+
+	// Same size and mtime is trusted; anything else has to hash the same,
+	// and is saved again with the new mtime so the next run trusts it.
+	bool refresh = false;
+	if (source.size != header.source_size)
+		return false;
+	if (source.mtime != header.source_mtime) {
+		const MappedFile content(image_path);
+		if (!content.isOpen() || hash_file(content) != header.source_hash)
+			return false;
+		refresh = true;
+	}
+
+	out.format = static_cast<TextureFormat>(header.format);
+	out.channels = static_cast<int>(header.channels);
+	out.levels.assign(header.levels, header.levels + header.level_count);
+	out.owned.reset();
+	out.data = reinterpret_cast<const unsigned char *>(mapping->begin() + header.data_offset);
+	out.size = header.data_size;
+	out.mapping = mapping;
+
+	if (refresh)
+		save_texture_cache(image_path, compressed, out);
+	return true;
+}
+
+void save_texture_cache(const std::string &image_path, const bool compressed, const TexturePixels &pixels) {
+	const MappedFile	content(image_path);
+	const FileStamp		source = stamp_file(image_path);
+
+	if (!content.isOpen() || !source.exists)
+		return ;
+
+	ScopTexHeader header{};
+	std::memcpy(header.magic, SCOPTEX_MAGIC, sizeof(SCOPTEX_MAGIC));
+	header.version = SCOPTEX_VERSION;
+	header.byte_order = SCOPTEX_BYTE_ORDER;
+	header.header_size = sizeof(ScopTexHeader);
+	header.source_size = source.size;
+	header.source_mtime = source.mtime;
+	header.source_hash = hash_file(content);
+	header.format = pixels.format;
+	header.channels = static_cast<uint32_t>(pixels.channels);
+	header.level_count = static_cast<uint32_t>(pixels.levels.size());
+	std::copy(pixels.levels.begin(), pixels.levels.end(), header.levels);
+	header.data_offset = align16(sizeof(ScopTexHeader));
+	header.data_size = pixels.size;
+
+	static const char padding[16] = {};
+	const std::vector<std::pair<const void *, size_t>> parts = {
+		{&header, sizeof(header)},
+		{padding, header.data_offset - sizeof(header)},
+		{pixels.data, pixels.size},
+	};
+	if (!write_file_atomic(cache_path(image_path, compressed), parts)) {
+		if constexpr (DEBUG) {
+			std::cout << "Could not write " << cache_path(image_path, compressed) << std::endl;
+		}
+	}
+}
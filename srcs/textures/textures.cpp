@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "../../headers/textures/textures.hpp"
+#include "../../headers/textures/block_compress.hpp"
+#include "../../headers/textures/decoder.hpp"
+#include "../../headers/pool/pool.hpp"
+
+// Formats by channel count. Grey images are swizzled so they stay grey
+// instead of turning red.
+struct PixelFormat {
+	GLint	internal;
+	GLenum	format;
+	GLint	swizzle[4];
+};
+
+static const PixelFormat PIXEL_FORMATS[4] = {
+	{GL_R8, GL_RED, {GL_RED, GL_RED, GL_RED, GL_ONE}},
+	{GL_RG8, GL_RG, {GL_RED, GL_RED, GL_RED, GL_GREEN}},
+	{GL_RGB8, GL_RGB, {GL_RED, GL_GREEN, GL_BLUE, GL_ONE}},
+	{GL_RGBA8, GL_RGBA, {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}},
+};
+
+// RGTC, for BC5, is core since 3.0; S3TC is still an extension.
+static const GLenum BLOCK_FORMATS[] = {
+	0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RG_RGTC2,
+};
+
+TextureStreamer::TextureStreamer(std::vector<std::string> paths, const bool compress, const size_t budget)
+	: paths(std::move(paths)), compress(compress), s3tc(GLEW_EXT_texture_compression_s3tc),
+	  textures(this->paths.size()) {
+	stats.budget = budget;
+}
+
+// A decode still running owns its DecodedImage and frees it when done.
+TextureStreamer::~TextureStreamer() {
+	if (fence)
+		glDeleteSync(fence);
+	glDeleteBuffers(1, &pbo);
+	glDeleteTextures(1, &next);
+	for (const Resident &texture : textures)
+		glDeleteTextures(1, &texture.id);
+}
+
+void TextureStreamer::request(const size_t texture) {
+	if (texture < paths.size())
+		requested = texture;
+}
+
+const TextureStats &TextureStreamer::getStats() const {
+	return stats;
+}
+
+// Bytes of the levels from `base` down, as uploaded.
+static size_t chain_size(const TexturePixels &pixels, const size_t base) {
+	size_t size = 0;
+
+	for (size_t level = base; level < pixels.levels.size(); ++level)
+		size += pixels.levelSize(level);
+	return size;
+}
+
+// First level no larger than TEXTURE_TAIL_SIZE, the start of the stream.
+static size_t tail_level(const TexturePixels &pixels) {
+	size_t level = 0;
+
+	while (level + 1 < pixels.levels.size()
+		&& std::max(pixels.levels[level].width, pixels.levels[level].height) > TEXTURE_TAIL_SIZE)
+		++level;
+	return level;
+}
+
+GLuint TextureStreamer::bound() const {
+	return shown < textures.size() ? textures[shown].id : 0;
+}
+
+// The requested texture, else the next one after it still to load.
+size_t TextureStreamer::pending() const {
+	if (requested >= paths.size())
+		return SIZE_MAX;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		const size_t texture = (requested + i) % paths.size();
+		if (!textures[texture].image && !textures[texture].failed)
+			return texture;
+	}
+	return SIZE_MAX;
+}
+
+// First level from which the chain fits in `room` bytes; the last level
+// always stays.
+size_t TextureStreamer::fittingBase(const size_t texture, const size_t room) const {
+	const TexturePixels	&pixels = textures[texture].image->pixels;
+	size_t				base = 0;
+
+	if (!stats.budget)
+		return 0;
+	while (base + 1 < pixels.levels.size() && chain_size(pixels, base) > room)
+		++base;
+	return base;
+}
+
+// The texture shown longest ago that still has a level to give up.
+size_t TextureStreamer::leastRecentlyUsed() const {
+	size_t victim = SIZE_MAX;
+
+	for (size_t i = 0; i < textures.size(); ++i) {
+		const Resident &texture = textures[i];
+		if (i == requested || !texture.id || texture.base + 1 >= texture.image->pixels.levels.size())
+			continue ;
+		if (victim == SIZE_MAX || texture.used < textures[victim].used)
+			victim = i;
+	}
+	return victim;
+}
+
+// Starts the next upload of `texture`, if its levels are ready for it:
+// the tail first, then one level more. Past the budget, only a texture
+// that may `evict` goes on, by taking a level from the least recently
+// shown one.
+bool TextureStreamer::step(const size_t texture, const bool evict) {
+	const Resident &resident = textures[texture];
+
+	if (!resident.image)
+		return false;
+	const size_t ready = resident.image->ready.load(std::memory_order_acquire);
+	if (ready >= TEXTURE_MAX_LEVELS)
+		return false;
+
+	const TexturePixels &pixels = resident.image->pixels;
+	if (!resident.id) {
+		const size_t room = stats.resident < stats.budget ? stats.budget - stats.resident : 0;
+		const size_t base = std::max(tail_level(pixels), fittingBase(texture, evict ? stats.budget : room));
+		if (base < ready)
+			return false;
+		upload(texture, base);
+		return true;
+	}
+	if (resident.base == 0 || resident.base - 1 < ready)
+		return false;
+
+	const size_t level = resident.base - 1;
+	if (stats.budget) {
+		if (chain_size(pixels, level) > stats.budget)
+			return false;
+		if (stats.resident + pixels.levelSize(level) > stats.budget) {
+			const size_t victim = evict ? leastRecentlyUsed() : SIZE_MAX;
+			if (victim == SIZE_MAX)
+				return false;
+			upload(victim, textures[victim].base + 1);
+			return true;
+		}
+	}
+	upload(texture, level);
+	return true;
+}
+
+// Starts the next upload, if any is due: the shown texture's, then the
+// levels over the budget, then the other textures'.
+bool TextureStreamer::stream() {
+	if (requested >= textures.size())
+		return false;
+	if (step(requested, true))
+		return true;
+	if (stats.budget && stats.resident > stats.budget) {
+		const size_t victim = leastRecentlyUsed();
+		if (victim != SIZE_MAX) {
+			upload(victim, textures[victim].base + 1);
+			return true;
+		}
+	}
+	for (size_t i = 1; i < textures.size(); ++i)
+		if (step((requested + i) % textures.size(), false))
+			return true;
+	return false;
+}
+
+void TextureStreamer::decode(const size_t texture) {
+	auto image = std::make_shared<DecodedImage>();
+
+	image->path = paths[texture];
+	image->index = texture;
+	decoding = image;
+	textures[texture].image = image;
+	ThreadPool::shared().submit([image, compress = compress, s3tc = s3tc]() {
+		// A cache in another format, written by a run with or without S3TC,
+		// is rebuilt for this one.
+		if (load_texture_cache(image->path, compress, image->pixels)
+			&& (!compress || image->pixels.format == block_format(image->pixels.channels, s3tc))) {
+			image->ready.store(0, std::memory_order_release);
+			if constexpr (DEBUG) {
+				std::cout << "Texture loaded from the cache of " << image->path << std::endl;
+			}
+		}
+		else {
+			DecodedPixels decoded;
+
+			image->pixels = TexturePixels();
+			if (decode_image(image->path, default_image_decoder(), 0, decoded)) {
+				TexturePixels raw;
+				build_mip_chain(decoded.data.get(), decoded.width, decoded.height, decoded.channels, raw);
+				decoded.data.reset();
+				const TextureFormat format = compress ? block_format(decoded.channels, s3tc) : TEXTURE_RAW;
+				if (format != TEXTURE_RAW)
+					compress_mip_chain(raw, format, image->pixels, [&image](const size_t level) {
+						image->ready.store(level, std::memory_order_release);
+					});
+				else {
+					image->pixels = std::move(raw);
+					image->ready.store(0, std::memory_order_release);
+				}
+				save_texture_cache(image->path, compress, image->pixels);
+				// The chain is kept for as long as the texture: mapped from
+				// the cache just written, it costs no memory of its own.
+				load_texture_cache(image->path, compress, image->mapped);
+			}
+		}
+		image->done.store(true, std::memory_order_release);
+	});
+}
+
+// Levels from `base` down: one more level of the texture, or all of them
+// into a new texture that replaces it once resident. The copy into the
+// buffer is the only work left on this thread; the driver reads the buffer
+// when it gets to the upload.
+void TextureStreamer::upload(const size_t texture, const size_t base) {
+	const Resident		&resident = textures[texture];
+	const TexturePixels	&pixels = resident.image->pixels;
+	const PixelFormat	&format = PIXEL_FORMATS[pixels.channels - 1];
+	const bool			adding = resident.id && base + 1 == resident.base;
+	const size_t		last = adding ? base + 1 : pixels.levels.size();
+	const size_t		first = pixels.levels[base].offset;
+	const size_t		size = (last < pixels.levels.size() ? pixels.levels[last].offset : pixels.size) - first;
+
+	glGenBuffers(1, &pbo);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+	void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped) {
+		std::memcpy(mapped, pixels.data + first, size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);	// upload from the client memory instead
+
+	if (adding)
+		glBindTexture(GL_TEXTURE_2D, resident.id);
+	else {
+		glGenTextures(1, &next);
+		glBindTexture(GL_TEXTURE_2D, next);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(base));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(pixels.levels.size() - 1));
+		glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, format.swizzle);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);		// rows of 3 bytes per pixel are not 4-aligned
+	for (size_t level = base; level < last; ++level) {
+		const MipLevel	&mip = pixels.levels[level];
+		const void		*source = mapped ? reinterpret_cast<const void *>(mip.offset - first) : pixels.data + mip.offset;
+
+		if (pixels.format != TEXTURE_RAW)
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), BLOCK_FORMATS[pixels.format],
+								   static_cast<GLsizei>(mip.width), static_cast<GLsizei>(mip.height), 0,
+								   static_cast<GLsizei>(pixels.levelSize(level)), source);
+		else
+			glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), format.internal, static_cast<GLsizei>(mip.width),
+						 static_cast<GLsizei>(mip.height), 0, format.format, GL_UNSIGNED_BYTE, source);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, bound());
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	uploading = texture;
+	uploading_base = base;
+}
+
+// A new texture takes the place of the old one, which is freed; an added
+// level becomes the base of its texture.
+void TextureStreamer::finishUpload() {
+	Resident			&texture = textures[uploading];
+	const TexturePixels	&pixels = texture.image->pixels;
+
+	glDeleteSync(fence);
+	glDeleteBuffers(1, &pbo);
+	fence = nullptr;
+	pbo = 0;
+	if (!next) {
+		glBindTexture(GL_TEXTURE_2D, texture.id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(uploading_base));
+		glBindTexture(GL_TEXTURE_2D, bound());
+		stats.resident += pixels.levelSize(uploading_base);
+		if (uploading_base >= texture.reached)
+			++stats.restored;
+	}
+	else {
+		if (texture.id) {
+			glDeleteTextures(1, &texture.id);
+			stats.resident -= chain_size(pixels, texture.base);
+			stats.dropped += uploading_base - texture.base;
+		}
+		else {
+			++stats.textures;
+			stats.full += chain_size(pixels, 0);
+		}
+		texture.id = next;
+		next = 0;
+		stats.resident += chain_size(pixels, uploading_base);
+	}
+	texture.base = uploading_base;
+	texture.reached = std::min(texture.reached, texture.base);
+	stats.reduced = 0;
+	for (const Resident &other : textures)
+		stats.reduced += other.id && other.base > 0;
+	if constexpr (DEBUG) {
+		std::cout << "Texture " << paths[uploading] << " resident from level " << texture.base << " of "
+			<< pixels.levels.size() << std::endl;
+	}
+	uploading = SIZE_MAX;
+}
+
+GLuint TextureStreamer::poll() {
+	if (fence) {
+		const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return bound();
+		finishUpload();
+	}
+
+	if (decoding && decoding->done.load(std::memory_order_acquire)) {
+		const std::shared_ptr<DecodedImage> image = std::move(decoding);
+		if (image->pixels.levels.empty()) {
+			std::cerr << "Texture " << image->path << " could not be loaded." << std::endl;
+			textures[image->index].image.reset();
+			textures[image->index].failed = true;
+		}
+		// Same levels at the same offsets: what was uploaded stays valid.
+		else if (!image->mapped.levels.empty())
+			image->pixels = std::move(image->mapped);
+	}
+	// One image decodes while the others' levels upload.
+	if (!decoding) {
+		const size_t texture = pending();
+		if (texture != SIZE_MAX)
+			decode(texture);
+	}
+	if (!fence)
+		stream();
+	if (requested < textures.size() && textures[requested].id)
+		shown = requested;
+	if (shown < textures.size())
+		textures[shown].used = ++frame;
+	return bound();
+}
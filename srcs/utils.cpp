@@ -1,13 +1,13 @@
 #include "../headers/scop.hpp"
 
-glm::vec3 calculateCenter(const std::vector<float> &triangles) {
+glm::vec3 calculateCenter(const float *vertices, const size_t size) {
 	glm::vec3 sum(0.0f);
-	const size_t totalVertices = triangles.size() / 5;
+	const size_t totalVertices = size / VERTEX_FLOATS;
 
-	for (size_t i = 0; i < triangles.size(); i += 5) {
-		sum.x += triangles[i];
-		sum.y += triangles[i + 1];
-		sum.z += triangles[i + 2];
+	for (size_t i = 0; i < size; i += VERTEX_FLOATS) {
+		sum.x += vertices[i];
+		sum.y += vertices[i + 1];
+		sum.z += vertices[i + 2];
 	}
 	return sum / static_cast<float>(totalVertices);
 }